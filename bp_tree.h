@@ -0,0 +1,490 @@
+#ifndef BP_TREE_H
+#define BP_TREE_H
+
+// Succinct ordinal tree in balanced-parentheses (BP) form.
+//
+// A preorder walk writes '(' (bit 1) when it enters a node and ')' (bit 0)
+// when it leaves, so a tree of n nodes is 2n bits plus one label byte per
+// node in preorder. A node is identified by the position of its '('.
+//
+// Let E(p) be the excess (#'(' - #')') of bits [0, p]. Then
+//   depth(i)        = E(i) - 1
+//   findclose(i)    = first j > i with E(j) = E(i) - 1
+//   parent(i)       = 1 + last j < i with E(j) = E(i) - 2
+// Directories on top of the bits:
+//   rank     one cumulative count per 512-bit block (rank1 in O(1))
+//   select   binary search over the rank samples, then a word scan
+//   excess   per-block minimum excess in a complete binary tree (a small
+//            range-min-max tree), so forward/backward excess searches
+//            skip whole blocks in O(log n); inside a block they scan a
+//            byte at a time with 256-entry min/total tables.
+// Extra space is about 0.25 bits per node on top of the 2n bits.
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef BP_BLOCK_BITS
+#define BP_BLOCK_BITS 512
+#endif
+#define BP_WORDS_PER_BLOCK (BP_BLOCK_BITS / 64)
+#define BP_NONE (-2LL)   // -1 is reserved for the virtual position before bit 0
+
+typedef struct {
+    uint64_t *words;
+    size_t bitCount;
+    size_t wordCapacity;
+    unsigned char *labels;
+    size_t labelCount;
+    size_t labelCapacity;
+    uint64_t *rankSamples;    // ones before each block
+    int32_t *minTree;         // leaves at [leafBase, leafBase + blockCount)
+    size_t blockCount;
+    size_t leafBase;
+} BpTree;
+
+static int8_t bp_byte_min[256];
+static int8_t bp_byte_total[256];
+static int bp_tables_ready = 0;
+
+static void bp_build_tables(void) {
+    if (bp_tables_ready) return;
+    for (int value = 0; value < 256; value++) {
+        int excess = 0, min = 8;
+        for (int bit = 0; bit < 8; bit++) {
+            excess += (value >> bit & 1) ? 1 : -1;
+            if (excess < min) min = excess;
+        }
+        bp_byte_min[value] = (int8_t) min;
+        bp_byte_total[value] = (int8_t) excess;
+    }
+    bp_tables_ready = 1;
+}
+
+static inline void bp_init(BpTree *tree) {
+    memset(tree, 0, sizeof(*tree));
+}
+
+static inline void bp_free(BpTree *tree) {
+    free(tree->words);
+    free(tree->labels);
+    free(tree->rankSamples);
+    free(tree->minTree);
+    bp_init(tree);
+}
+
+static inline int bp_bit(const BpTree *tree, size_t position) {
+    return (int) (tree->words[position / 64] >> (position % 64) & 1);
+}
+
+// Appends '(' plus the node's label, or ')'. Returns 0 when out of memory.
+static inline int bp_append(BpTree *tree, int open, unsigned char label) {
+    if (tree->bitCount / 64 >= tree->wordCapacity) {
+        size_t newCapacity = tree->wordCapacity ? tree->wordCapacity * 2 : 1024;
+        uint64_t *grown = (uint64_t *) realloc(tree->words, sizeof(uint64_t) * newCapacity);
+        if (grown == NULL) return 0;
+        memset(grown + tree->wordCapacity, 0, sizeof(uint64_t) * (newCapacity - tree->wordCapacity));
+        tree->words = grown;
+        tree->wordCapacity = newCapacity;
+    }
+    if (open) {
+        if (tree->labelCount == tree->labelCapacity) {
+            size_t newCapacity = tree->labelCapacity ? tree->labelCapacity * 2 : 4096;
+            unsigned char *grown = (unsigned char *) realloc(tree->labels, newCapacity);
+            if (grown == NULL) return 0;
+            tree->labels = grown;
+            tree->labelCapacity = newCapacity;
+        }
+        tree->labels[tree->labelCount++] = label;
+        tree->words[tree->bitCount / 64] |= (uint64_t) 1 << (tree->bitCount % 64);
+    }
+    tree->bitCount++;
+    return 1;
+}
+
+// Number of '(' in [0, position).
+static inline size_t bp_rank1(const BpTree *tree, size_t position) {
+    size_t block = position / BP_BLOCK_BITS;
+    size_t count = tree->rankSamples[block];
+    size_t word = block * BP_WORDS_PER_BLOCK;
+
+    for (; word < position / 64; word++) {
+        count += (size_t) __builtin_popcountll(tree->words[word]);
+    }
+    if (position % 64) {
+        count += (size_t) __builtin_popcountll(tree->words[word] & (((uint64_t) 1 << (position % 64)) - 1));
+    }
+    return count;
+}
+
+// E(position): excess of bits [0, position]; E(-1) is 0.
+static inline long long bp_excess(const BpTree *tree, long long position) {
+    if (position < 0) return 0;
+    return 2 * (long long) bp_rank1(tree, (size_t) position + 1) - (position + 1);
+}
+
+// Position of the k-th '(' (k >= 1), i.e. the node with preorder rank k - 1.
+static inline long long bp_select1(const BpTree *tree, size_t k) {
+    if (k == 0 || k > tree->labelCount) return BP_NONE;
+    size_t low = 0, high = tree->blockCount;
+
+    while (high - low > 1) {
+        size_t mid = (low + high) / 2;
+        if (tree->rankSamples[mid] < k) low = mid;
+        else high = mid;
+    }
+    size_t remaining = k - tree->rankSamples[low];
+    size_t word = low * BP_WORDS_PER_BLOCK;
+    for (;; word++) {
+        size_t ones = (size_t) __builtin_popcountll(tree->words[word]);
+        if (ones >= remaining) break;
+        remaining -= ones;
+    }
+    uint64_t bits = tree->words[word];
+    while (--remaining) bits &= bits - 1;
+    return (long long) (word * 64) + __builtin_ctzll(bits);
+}
+
+// Fills rank samples and the block min-excess tree; call after the last append.
+static inline int bp_finalize(BpTree *tree) {
+    bp_build_tables();
+    tree->blockCount = (tree->bitCount + BP_BLOCK_BITS - 1) / BP_BLOCK_BITS;
+    if (tree->blockCount == 0) tree->blockCount = 1;
+    tree->leafBase = 1;
+    while (tree->leafBase < tree->blockCount) tree->leafBase *= 2;
+
+    size_t neededWords = tree->blockCount * BP_WORDS_PER_BLOCK;
+    if (neededWords > tree->wordCapacity) {
+        uint64_t *grown = (uint64_t *) realloc(tree->words, sizeof(uint64_t) * neededWords);
+        if (grown == NULL) return 0;
+        memset(grown + tree->wordCapacity, 0, sizeof(uint64_t) * (neededWords - tree->wordCapacity));
+        tree->words = grown;
+        tree->wordCapacity = neededWords;
+    }
+    tree->rankSamples = (uint64_t *) malloc(sizeof(uint64_t) * (tree->blockCount + 1));
+    tree->minTree = (int32_t *) malloc(sizeof(int32_t) * 2 * tree->leafBase);
+    if (tree->rankSamples == NULL || tree->minTree == NULL) return 0;
+
+    long long excess = 0;
+    uint64_t ones = 0;
+    for (size_t block = 0; block < tree->leafBase; block++) {
+        int32_t min = INT32_MAX;
+        if (block < tree->blockCount) {
+            tree->rankSamples[block] = ones;
+            size_t start = block * BP_BLOCK_BITS;
+            size_t end = start + BP_BLOCK_BITS < tree->bitCount ? start + BP_BLOCK_BITS : tree->bitCount;
+            for (size_t p = start; p < end;) {
+                if (p % 8 == 0 && p + 8 <= end) {
+                    unsigned char byte = (unsigned char) (tree->words[p / 64] >> (p % 64));
+                    if (excess + bp_byte_min[byte] < min) min = (int32_t) (excess + bp_byte_min[byte]);
+                    excess += bp_byte_total[byte];
+                    ones += (uint64_t) __builtin_popcount(byte);
+                    p += 8;
+                    continue;
+                }
+                int bit = bp_bit(tree, p);
+                ones += (uint64_t) bit;
+                excess += bit ? 1 : -1;
+                if (excess < min) min = (int32_t) excess;
+                p++;
+            }
+        }
+        tree->minTree[tree->leafBase + block] = min;
+    }
+    tree->rankSamples[tree->blockCount] = ones;
+    for (size_t v = tree->leafBase - 1; v >= 1; v--) {
+        int32_t left = tree->minTree[2 * v], right = tree->minTree[2 * v + 1];
+        tree->minTree[v] = left < right ? left : right;
+    }
+    return 1;
+}
+
+// First block >= from whose minimum excess is <= target, or BP_NONE.
+static inline long long bp_next_block(const BpTree *tree, size_t from, long long target) {
+    if (from >= tree->blockCount) return BP_NONE;
+    size_t v = tree->leafBase + from;
+
+    while (tree->minTree[v] > target) {
+        while (v > 1 && (v & 1)) v >>= 1;
+        if (v <= 1) return BP_NONE;
+        v++;
+    }
+    while (v < tree->leafBase) {
+        v *= 2;
+        if (tree->minTree[v] > target) v++;
+    }
+    return (long long) (v - tree->leafBase);
+}
+
+// Last block <= from whose minimum excess is <= target, or BP_NONE.
+static inline long long bp_prev_block(const BpTree *tree, long long from, long long target) {
+    if (from < 0) return BP_NONE;
+    size_t v = tree->leafBase + (size_t) from;
+
+    while (tree->minTree[v] > target) {
+        while (v > 1 && !(v & 1)) v >>= 1;
+        if (v <= 1) return BP_NONE;
+        v--;
+    }
+    while (v < tree->leafBase) {
+        v = 2 * v + 1;
+        if (tree->minTree[v] > target) v--;
+    }
+    return (long long) (v - tree->leafBase);
+}
+
+// Scans positions [from, end) with excess = E(from - 1) for the first
+// position whose excess equals target (< excess).
+static inline long long bp_scan_forward(const BpTree *tree, size_t from, size_t end, long long excess,
+                                        long long target) {
+    size_t p = from;
+    while (p < end) {
+        if (p % 8 == 0 && p + 8 <= end) {
+            unsigned char byte = (unsigned char) (tree->words[p / 64] >> (p % 64));
+            if (excess + bp_byte_min[byte] > target) {
+                excess += bp_byte_total[byte];
+                p += 8;
+                continue;
+            }
+        }
+        excess += bp_bit(tree, p) ? 1 : -1;
+        if (excess == target) return (long long) p;
+        p++;
+    }
+    return BP_NONE;
+}
+
+// Scans positions from `from` down to `low` with excess = E(from) for the
+// last position whose excess equals target (< excess).
+static inline long long bp_scan_backward(const BpTree *tree, long long from, long long low, long long excess,
+                                         long long target) {
+    long long p = from;
+    while (p >= low) {
+        if (p % 8 == 7 && p - 7 >= low) {
+            unsigned char byte = (unsigned char) (tree->words[p / 64] >> ((p - 7) % 64));
+            long long before = excess - bp_byte_total[byte];
+            if (before + bp_byte_min[byte] > target) {
+                excess = before;
+                p -= 8;
+                continue;
+            }
+        }
+        if (excess == target) return p;
+        excess -= bp_bit(tree, (size_t) p) ? 1 : -1;
+        p--;
+    }
+    return BP_NONE;
+}
+
+// First j > i with E(j) = target.
+static inline long long bp_fwd_search(const BpTree *tree, size_t i, long long target) {
+    size_t block = i / BP_BLOCK_BITS;
+    size_t blockEnd = (block + 1) * BP_BLOCK_BITS;
+    if (blockEnd > tree->bitCount) blockEnd = tree->bitCount;
+
+    long long found = bp_scan_forward(tree, i + 1, blockEnd, bp_excess(tree, (long long) i), target);
+    if (found != BP_NONE) return found;
+
+    long long next = bp_next_block(tree, block + 1, target);
+    if (next == BP_NONE) return BP_NONE;
+    size_t start = (size_t) next * BP_BLOCK_BITS;
+    size_t end = start + BP_BLOCK_BITS < tree->bitCount ? start + BP_BLOCK_BITS : tree->bitCount;
+    return bp_scan_forward(tree, start, end, bp_excess(tree, (long long) start - 1), target);
+}
+
+// Last j < i with E(j) = target; -1 stands for the virtual E(-1) = 0.
+static inline long long bp_bwd_search(const BpTree *tree, size_t i, long long target) {
+    long long block = (long long) (i / BP_BLOCK_BITS);
+    long long low = block * BP_BLOCK_BITS;
+    long long found = BP_NONE;
+
+    if (i > 0) found = bp_scan_backward(tree, (long long) i - 1, low, bp_excess(tree, (long long) i - 1), target);
+    if (found != BP_NONE) return found;
+
+    long long previous = bp_prev_block(tree, block - 1, target);
+    if (previous != BP_NONE) {
+        long long last = (previous + 1) * BP_BLOCK_BITS - 1;
+        return bp_scan_backward(tree, last, previous * BP_BLOCK_BITS, bp_excess(tree, last), target);
+    }
+    return target == 0 ? -1 : BP_NONE;
+}
+
+// ---- node navigation (a node is the position of its '(') ----
+
+static inline long long bp_root(const BpTree *tree) {
+    return tree->bitCount > 0 ? 0 : BP_NONE;
+}
+
+static inline size_t bp_preorder(const BpTree *tree, long long node) {
+    return bp_rank1(tree, (size_t) node + 1) - 1;
+}
+
+static inline unsigned char bp_label(const BpTree *tree, long long node) {
+    return tree->labels[bp_preorder(tree, node)];
+}
+
+static inline long long bp_find_close(const BpTree *tree, long long node) {
+    return bp_fwd_search(tree, (size_t) node, bp_excess(tree, node) - 1);
+}
+
+static inline long long bp_depth(const BpTree *tree, long long node) {
+    return bp_excess(tree, node) - 1;
+}
+
+static inline long long bp_subtree_size(const BpTree *tree, long long node) {
+    return (bp_find_close(tree, node) - node + 1) / 2;
+}
+
+static inline int bp_is_leaf(const BpTree *tree, long long node) {
+    return !bp_bit(tree, (size_t) node + 1);
+}
+
+static inline long long bp_first_child(const BpTree *tree, long long node) {
+    return bp_is_leaf(tree, node) ? BP_NONE : node + 1;
+}
+
+static inline long long bp_next_sibling(const BpTree *tree, long long node) {
+    long long next = bp_find_close(tree, node) + 1;
+    return (next < (long long) tree->bitCount && bp_bit(tree, (size_t) next)) ? next : BP_NONE;
+}
+
+static inline long long bp_parent(const BpTree *tree, long long node) {
+    long long excess = bp_excess(tree, node);
+    if (excess <= 1) return BP_NONE;
+    long long j = bp_bwd_search(tree, (size_t) node, excess - 2);
+    return j == BP_NONE ? BP_NONE : j + 1;
+}
+
+static inline size_t bp_memory_bytes(const BpTree *tree) {
+    return (tree->bitCount + 7) / 8 + tree->labelCount + sizeof(uint64_t) * (tree->blockCount + 1) +
+           sizeof(int32_t) * 2 * tree->leafBase;
+}
+
+// ---- binary file format ----
+//
+// A 64-byte header followed by the finalized tree, so a mapped file can be
+// navigated in place with no parsing and no directory rebuild:
+//   words        blockCount * BP_WORDS_PER_BLOCK uint64_t (structure bits)
+//   rankSamples  blockCount + 1 uint64_t
+//   minTree      2 * leafBase int32_t
+//   labels       labelCount bytes, one per node in preorder
+// Every section starts 8-byte aligned. Values are in host byte order; the
+// loader rejects files written with another byte order or block size.
+
+#define BP_FILE_MAGIC "BPTREE01"
+#define BP_FILE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t blockBits;
+    uint64_t bitCount;
+    uint64_t labelCount;
+    uint64_t blockCount;
+    uint64_t leafBase;
+    uint64_t reserved[2];
+} BpFileHeader;
+
+static inline size_t bp_file_size(const BpTree *tree) {
+    return sizeof(BpFileHeader) + sizeof(uint64_t) * tree->blockCount * BP_WORDS_PER_BLOCK +
+           sizeof(uint64_t) * (tree->blockCount + 1) + sizeof(int32_t) * 2 * tree->leafBase + tree->labelCount;
+}
+
+// Writes a finalized tree. Returns 0 on I/O error.
+static inline int bp_save(const BpTree *tree, const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) return 0;
+
+    BpFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BP_FILE_MAGIC, sizeof(header.magic));
+    header.byteOrder = BP_FILE_BYTE_ORDER;
+    header.blockBits = BP_BLOCK_BITS;
+    header.bitCount = tree->bitCount;
+    header.labelCount = tree->labelCount;
+    header.blockCount = tree->blockCount;
+    header.leafBase = tree->leafBase;
+
+    int ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(tree->words, sizeof(uint64_t), tree->blockCount * BP_WORDS_PER_BLOCK, fp) ==
+                 tree->blockCount * BP_WORDS_PER_BLOCK &&
+             fwrite(tree->rankSamples, sizeof(uint64_t), tree->blockCount + 1, fp) == tree->blockCount + 1 &&
+             fwrite(tree->minTree, sizeof(int32_t), 2 * tree->leafBase, fp) == 2 * tree->leafBase &&
+             fwrite(tree->labels, 1, tree->labelCount, fp) == tree->labelCount;
+    if (fclose(fp) != 0) ok = 0;
+    return ok;
+}
+
+// The header sizes must be the ones bp_finalize would derive from bitCount;
+// a file that only matches in total size would index past its sections.
+// bitCount is bounded by the file size first so the arithmetic cannot wrap.
+static inline int bp_header_valid(const BpFileHeader *header, size_t fileSize) {
+    if (header->bitCount > (uint64_t) fileSize * 8) return 0;
+    uint64_t blockCount = (header->bitCount + BP_BLOCK_BITS - 1) / BP_BLOCK_BITS;
+    if (blockCount == 0) blockCount = 1;
+    uint64_t leafBase = 1;
+    while (leafBase < blockCount) leafBase *= 2;
+    return header->blockCount == blockCount && header->leafBase == leafBase &&
+           header->bitCount % 2 == 0 && header->labelCount == header->bitCount / 2;
+}
+
+// Maps a file written by bp_save read-only and points the tree's arrays
+// into the mapping. Pages are read on first touch, so opening costs one
+// page-in for the header. Release with bp_unmap, never bp_free.
+static inline int bp_map(BpTree *tree, const char *path, void **mapping, size_t *mappedSize) {
+    bp_init(tree);
+    *mapping = NULL;
+    *mappedSize = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(BpFileHeader)) {
+        close(fd);
+        return 0;
+    }
+    void *base = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return 0;
+
+    const BpFileHeader *header = (const BpFileHeader *) base;
+    tree->bitCount = (size_t) header->bitCount;
+    tree->labelCount = (size_t) header->labelCount;
+    tree->blockCount = (size_t) header->blockCount;
+    tree->leafBase = (size_t) header->leafBase;
+    if (memcmp(header->magic, BP_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->byteOrder != BP_FILE_BYTE_ORDER || header->blockBits != BP_BLOCK_BITS ||
+        !bp_header_valid(header, (size_t) info.st_size) || bp_file_size(tree) != (size_t) info.st_size) {
+        munmap(base, (size_t) info.st_size);
+        bp_init(tree);
+        return 0;
+    }
+
+    unsigned char *cursor = (unsigned char *) base + sizeof(BpFileHeader);
+    tree->words = (uint64_t *) cursor;
+    tree->wordCapacity = tree->blockCount * BP_WORDS_PER_BLOCK;
+    cursor += sizeof(uint64_t) * tree->wordCapacity;
+    tree->rankSamples = (uint64_t *) cursor;
+    cursor += sizeof(uint64_t) * (tree->blockCount + 1);
+    tree->minTree = (int32_t *) cursor;
+    cursor += sizeof(int32_t) * 2 * tree->leafBase;
+    tree->labels = cursor;
+    tree->labelCapacity = tree->labelCount;
+
+    bp_build_tables();
+    *mapping = base;
+    *mappedSize = (size_t) info.st_size;
+    return 1;
+}
+
+static inline void bp_unmap(BpTree *tree, void *mapping, size_t mappedSize) {
+    if (mapping != NULL) munmap(mapping, mappedSize);
+    bp_init(tree);
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef EYTZINGER_H
+#define EYTZINGER_H
+
+// Static search array for the lookup comparisons in subject4.c and
+// subject5.c. Sorted keys are stored in Eytzinger (BFS) order: keys[1] is
+// the median, and the children of keys[k] are keys[2k] and keys[2k + 1].
+// The search walks down with k = 2k + (keys[k] < key), so there is no
+// data-dependent branch. The 16 descendants four levels below k sit in
+// one 64-byte line, which is prefetched while the next levels are read.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EYTZINGER_LINE 64
+#define EYTZINGER_PREFETCH_LEVELS 4
+
+typedef struct {
+    int *keys;      // keys[1..count]; keys[0] is unused
+    size_t count;
+    void *block;    // allocation behind keys
+} EytzingerArray;
+
+// Fills the layout with an in-order walk of the implicit tree, so the BFS
+// positions receive the sorted keys in ascending order.
+static inline void eytzinger_fill(EytzingerArray *array, const int sorted[]) {
+    size_t next = 0;
+    size_t k = 1;
+    for (;;) {
+        while (k <= array->count) k *= 2;
+        // k went one past a left spine; climb while we came from a right child
+        k >>= __builtin_ctzll(~(unsigned long long) k) + 1;
+        if (k == 0) break;
+        array->keys[k] = sorted[next++];
+        k = 2 * k + 1;
+    }
+}
+
+// Builds from `count` keys in ascending order. Returns 0 when out of memory.
+static inline int eytzinger_build(EytzingerArray *array, const int sorted[], size_t count) {
+    array->count = count;
+    array->keys = NULL;
+    array->block = malloc(sizeof(int) * (count + 1) + EYTZINGER_LINE);
+    if (array->block == NULL) return 0;
+    // keys[16k] starts a cache line, so a prefetch of keys[16k] covers all 16 descendants
+    uintptr_t aligned = ((uintptr_t) array->block + EYTZINGER_LINE - 1) & ~(uintptr_t) (EYTZINGER_LINE - 1);
+    array->keys = (int *) aligned;
+    eytzinger_fill(array, sorted);
+    return 1;
+}
+
+static inline void eytzinger_free(EytzingerArray *array) {
+    free(array->block);
+    memset(array, 0, sizeof(*array));
+}
+
+// Position of the first key >= `key`, or 0 when every key is smaller.
+// *levels (if not NULL) receives the number of keys compared on the way down.
+static inline size_t eytzinger_lower_bound(const EytzingerArray *array, int key, int *levels) {
+    const int *keys = array->keys;
+    size_t count = array->count;
+    size_t k = 1;
+    int steps = 0;
+    while (k <= count) {
+        __builtin_prefetch(keys + (k << EYTZINGER_PREFETCH_LEVELS));
+        k = 2 * k + (keys[k] < key);
+        steps++;
+    }
+    // Drop the trailing right turns and the final left turn: that is the last
+    // node where the search went left, i.e. the smallest key >= `key`.
+    k >>= __builtin_ctzll(~(unsigned long long) k) + 1;
+    if (levels != NULL) *levels = steps;
+    return k;
+}
+
+static inline int eytzinger_contains(const EytzingerArray *array, int key, int *levels) {
+    size_t k = eytzinger_lower_bound(array, key, levels);
+    return k != 0 && array->keys[k] == key;
+}
+
+#endif
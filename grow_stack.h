@@ -0,0 +1,59 @@
+#ifndef GROW_STACK_H
+#define GROW_STACK_H
+
+// Heap-allocated int stack that doubles when full, used by the explicit-
+// stack parsers so nesting depth is bounded by memory, not the C stack.
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define GROW_STACK_INITIAL 64
+
+// Parse benchmarks only run the recursive parsers up to this nesting depth;
+// deeper inputs would overflow a default 8 MB thread stack.
+#define RECURSIVE_BENCH_DEPTH_LIMIT 20000
+
+typedef struct {
+    int *items;
+    size_t count;
+    size_t capacity;
+} GrowStack;
+
+static inline void grow_stack_init(GrowStack *stack) {
+    stack->items = NULL;
+    stack->count = 0;
+    stack->capacity = 0;
+}
+
+static inline void grow_stack_free(GrowStack *stack) {
+    free(stack->items);
+    grow_stack_init(stack);
+}
+
+static inline int grow_stack_is_empty(const GrowStack *stack) {
+    return stack->count == 0;
+}
+
+// Returns 0 when the stack could not grow; the value is not pushed.
+static inline int grow_stack_push(GrowStack *stack, int value) {
+    if (stack->count == stack->capacity) {
+        size_t newCapacity = stack->capacity ? stack->capacity * 2 : GROW_STACK_INITIAL;
+        int *grown = (int *) realloc(stack->items, sizeof(int) * newCapacity);
+        if (grown == NULL) return 0;
+        stack->items = grown;
+        stack->capacity = newCapacity;
+    }
+    stack->items[stack->count++] = value;
+    return 1;
+}
+
+static inline int grow_stack_pop(GrowStack *stack) {
+    return stack->items[--stack->count];
+}
+
+// Pointer to the top item (or to the item `depth` below it).
+static inline int *grow_stack_peek(GrowStack *stack, size_t depth) {
+    return &stack->items[stack->count - 1 - depth];
+}
+
+#endif
@@ -1,6 +1,19 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "grow_stack.h"
+#include "line_batch.h"
+#include "sexpr_classify.h"
+#include "sibling_index.h"
+
+#define STREAM_CHUNK_SIZE (64 * 1024)
 
 typedef enum {
     STATUS_OPEN,
@@ -104,28 +117,563 @@ int validate_tree(const char input[], int *cursor, ParseStatus status) {
     return childCount;
 }
 
-int main(void) {
-    char buffer[256];
-    printf("Input:");
-    scanf("%[^\n]", buffer);
+// Explicit-stack version of validate_tree(input, cursor, STATUS_ROOT): one
+// child counter per open list lives on a heap stack instead of a C frame.
+int validate_tree_iterative(const char input[], size_t *cursor) {
+    GrowStack childCounts;
+    grow_stack_init(&childCounts);
+    int validationResult = 0;
+    int finished = !grow_stack_push(&childCounts, 0);
 
-    int cursor = 0;
-    int validationResult = -1;
+    if (finished) validationResult = -1;
+    while (!finished && input[*cursor] != '\0') {
+        while (isspace((unsigned char) input[*cursor])) (*cursor)++;
 
-    while (buffer[cursor] != '\0') {
-        if (buffer[cursor] == '\n') {
-            printf("\nOutput: ERROR\n");
-            return 0;
+        if (input[*cursor] == '\0') break; // the recursive version counts one atom past the end here
+
+        if (input[*cursor] == ')') {
+            if (childCounts.count == 1) {
+                validationResult = -1;
+                finished = 1;
+                break;
+            }
+            (*cursor)++;
+            int subtreeCount = grow_stack_pop(&childCounts);
+            if (subtreeCount > 2) {
+                validationResult = subtreeCount;
+                finished = 1;
+            }
+            continue;
         }
-        cursor++;
+
+        if (input[*cursor] == '(') {
+            (*cursor)++;
+            if (!grow_stack_push(&childCounts, 0)) {
+                validationResult = -1;
+                finished = 1;
+            }
+            continue;
+        }
+
+        (*grow_stack_peek(&childCounts, 0))++;
+        (*cursor)++;
     }
 
-    cursor = 0;
-    if (validate_parentheses(buffer, &cursor) && validate_root_label(buffer, &cursor)) {
-        cursor = 0;
-        validationResult = validate_tree(buffer, &cursor, STATUS_ROOT);
+    if (!finished) {
+        validationResult = (childCounts.count == 1) ? childCounts.items[0] : -1;
+    }
+    grow_stack_free(&childCounts);
+    return validationResult;
+}
+
+// Fused single-pass validator: runs the checks of validate_parentheses,
+// validate_root_label and validate_tree together over input fed in chunks.
+// Only the per-level child counters of validate_tree grow with depth; each
+// one saturates at 3 since callers only distinguish <2, 2 and >2.
+// Input is classified 64 bytes at a time and only non-space positions are
+// visited, so runs of whitespace cost one mask test.
+typedef struct {
+    long long balance;
+    int parenthesesFailed;
+    long long rootDepthLevel;
+    int rootLabelCount;
+    long long treeDepth;
+    unsigned char *childCounts;
+    long long childCountsCapacity;
+    int treeResult;
+    int treeDone;
+    long long bytesConsumed;
+    SexprClassifier classify;
+} StreamValidator;
+
+void stream_validator_init(StreamValidator *validator) {
+    memset(validator, 0, sizeof(*validator));
+    validator->childCountsCapacity = 64;
+    validator->childCounts = (unsigned char *) calloc((size_t) validator->childCountsCapacity, 1);
+    validator->classify = sexpr_classify_simd;
+}
+
+void stream_validator_reset(StreamValidator *validator) {
+    unsigned char *childCounts = validator->childCounts;
+    long long childCountsCapacity = validator->childCountsCapacity;
+    SexprClassifier classify = validator->classify;
+
+    memset(validator, 0, sizeof(*validator));
+    validator->childCounts = childCounts;
+    validator->childCountsCapacity = childCountsCapacity;
+    validator->classify = classify;
+    validator->childCounts[0] = 0;
+}
+
+void stream_validator_free(StreamValidator *validator) {
+    free(validator->childCounts);
+    validator->childCounts = NULL;
+}
+
+static int stream_validator_push_level(StreamValidator *validator) {
+    if (validator->treeDepth + 1 >= validator->childCountsCapacity) {
+        long long newCapacity = validator->childCountsCapacity * 2;
+        unsigned char *grown = (unsigned char *) realloc(validator->childCounts, (size_t) newCapacity);
+        if (grown == NULL) return 0;
+        validator->childCounts = grown;
+        validator->childCountsCapacity = newCapacity;
+    }
+    validator->treeDepth++;
+    validator->childCounts[validator->treeDepth] = 0;
+    return 1;
+}
+
+void stream_validator_feed(StreamValidator *validator, const char chunk[], size_t length) {
+    long long balance = validator->balance;
+    long long rootDepthLevel = validator->rootDepthLevel;
+    int rootLabelCount = validator->rootLabelCount;
+
+    for (size_t base = 0; base < length; base += SEXPR_BLOCK) {
+        size_t blockLength = length - base < SEXPR_BLOCK ? length - base : SEXPR_BLOCK;
+        SexprMasks masks;
+        validator->classify(chunk + base, blockLength, &masks);
+
+        uint64_t validMask = blockLength == SEXPR_BLOCK ? ~(uint64_t) 0 : (((uint64_t) 1 << blockLength) - 1);
+        uint64_t pending = ~masks.space & validMask;
+
+        while (pending != 0) {
+            uint64_t bit = pending & (~pending + 1);
+            pending ^= bit;
+
+            if (masks.open & bit) {
+                balance++;
+                rootDepthLevel++;
+                if (!validator->treeDone && !stream_validator_push_level(validator)) {
+                    validator->treeResult = -1;
+                    validator->treeDone = 1;
+                }
+            } else if (masks.close & bit) {
+                if (balance < 0) validator->parenthesesFailed = 1;
+                balance--;
+                if (rootDepthLevel > 0) rootDepthLevel--;
+                if (validator->treeDone) continue;
+                if (validator->treeDepth == 0) {
+                    validator->treeResult = -1;
+                    validator->treeDone = 1;
+                    continue;
+                }
+                int subtreeCount = validator->childCounts[validator->treeDepth--];
+                if (subtreeCount > 2) {
+                    validator->treeResult = subtreeCount;
+                    validator->treeDone = 1;
+                }
+            } else {
+                if (rootDepthLevel == 1 && (masks.label & bit) && rootLabelCount < 2) rootLabelCount++;
+                if (!validator->treeDone && validator->childCounts[validator->treeDepth] < 3) {
+                    validator->childCounts[validator->treeDepth]++;
+                }
+            }
+        }
+    }
+    validator->balance = balance;
+    validator->rootDepthLevel = rootDepthLevel;
+    validator->rootLabelCount = rootLabelCount;
+    validator->bytesConsumed += (long long) length;
+}
+
+int stream_validator_finish(StreamValidator *validator) {
+    if (validator->parenthesesFailed || validator->balance != 0) return -1;
+    if (validator->rootLabelCount != 1) return -1;
+    if (validator->treeDone) return validator->treeResult;
+    if (validator->treeDepth != 0) return -1;
+    return validator->childCounts[0];
+}
+
+// Incremental validation of an edited document. The text is kept as a tree
+// of parenthesis groups holding the counts the validators look at; an edit
+// re-scans only the smallest group whose contents still balance on their
+// own, jumping over child groups the edit does not touch. Groups and child
+// lists are append-only arrays, so replaced groups simply stay behind.
+// Group starts are kept on an int GrowStack while re-scanning, so documents
+// longer than INCREMENTAL_MAX_LENGTH are refused.
+#define NO_GROUP UINT32_MAX
+#define INCREMENTAL_MAX_LENGTH ((size_t) INT_MAX)
+
+typedef struct {
+    uint32_t gap;        // from the parent's content start or the previous sibling's ')'
+    uint32_t length;     // including both parentheses
+    uint32_t firstChild;
+    uint32_t childCount;
+    uint32_t items;      // direct non-space characters other than parentheses
+    uint32_t alpha;      // direct letters
+    uint32_t badGroups;  // groups in this subtree with more than two items
+    uint32_t siblingIndex; // child extent sums in siblingSums, or SIBLING_INDEX_NONE
+} ParenGroup;
+
+typedef struct {
+    char *text;
+    size_t length;
+    size_t capacity;
+    ParenGroup *groups;
+    uint32_t groupCount;
+    uint32_t groupCapacity;
+    uint32_t *children;
+    uint32_t childCount;
+    uint32_t childCapacity;
+    uint32_t *pending;
+    uint32_t pendingCount;
+    uint32_t pendingCapacity;
+    SiblingIndexPool siblingSums;
+    // Virtual group spanning the whole document (no parentheses); NO_GROUP
+    // while the parentheses do not balance.
+    uint32_t root;
+    uint32_t rootAlpha;  // letters directly inside depth-1 groups
+    long long rescannedBytes;
+} IncrementalValidator;
+
+static int grow_array(void **array, uint32_t *capacity, uint32_t needed, size_t elementSize) {
+    if (needed <= *capacity) return 1;
+    uint32_t newCapacity = *capacity ? *capacity : 1024;
+    while (newCapacity < needed) newCapacity *= 2;
+    void *grown = realloc(*array, elementSize * newCapacity);
+    if (grown == NULL) return 0;
+    *array = grown;
+    *capacity = newCapacity;
+    return 1;
+}
+
+static uint32_t incremental_new_group(IncrementalValidator *validator, uint32_t gap, uint32_t start) {
+    if (!grow_array((void **) &validator->groups, &validator->groupCapacity, validator->groupCount + 1,
+                    sizeof(ParenGroup))) {
+        return NO_GROUP;
+    }
+    ParenGroup *group = &validator->groups[validator->groupCount];
+    memset(group, 0, sizeof(*group));
+    group->gap = gap;
+    group->length = start; // replaced by the real length when the group closes
+    group->siblingIndex = SIBLING_INDEX_NONE;
+    return validator->groupCount++;
+}
+
+static int incremental_push_pending(IncrementalValidator *validator, uint32_t group) {
+    if (!grow_array((void **) &validator->pending, &validator->pendingCapacity, validator->pendingCount + 1,
+                    sizeof(uint32_t))) {
+        return 0;
+    }
+    validator->pending[validator->pendingCount++] = group;
+    return 1;
+}
+
+// Turns pending[mark..] into the child list of `group` and totals its counts.
+static int incremental_close_group(IncrementalValidator *validator, uint32_t group, uint32_t mark, size_t end) {
+    uint32_t count = validator->pendingCount - mark;
+    if (!grow_array((void **) &validator->children, &validator->childCapacity, validator->childCount + count,
+                    sizeof(uint32_t))) {
+        return 0;
+    }
+    ParenGroup *closed = &validator->groups[group];
+    closed->length = (uint32_t) (end - closed->length);
+    closed->firstChild = validator->childCount;
+    closed->childCount = count;
+    closed->badGroups = closed->items > 2;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t child = validator->pending[mark + i];
+        validator->children[validator->childCount++] = child;
+        closed->badGroups += validator->groups[child].badGroups;
+    }
+    validator->pendingCount = mark;
+
+    if (count >= SIBLING_INDEX_MIN_CHILDREN) {
+        uint32_t base = sibling_index_alloc(&validator->siblingSums, count);
+        if (base == SIBLING_INDEX_NONE) return 1; // the child list is walked instead
+        for (uint32_t i = 0; i < count; i++) {
+            const ParenGroup *child = &validator->groups[validator->children[closed->firstChild + i]];
+            validator->siblingSums.sums[base + i] = child->gap + child->length;
+        }
+        sibling_index_finish(&validator->siblingSums, base, count);
+        closed->siblingIndex = base;
+    }
+    return 1;
+}
+
+// Scans text[start, start + length) as one group (the whole document when
+// isRoot). `old` is the group it replaces, NO_GROUP for a fresh scan; its
+// children lying entirely before `offset` or at/after `offset + deleted`
+// (old positions) are reused. Returns NO_GROUP and rolls back when the
+// contents do not balance.
+static uint32_t incremental_rescan(IncrementalValidator *validator, uint32_t old, size_t start, size_t length,
+                                   size_t offset, size_t deleted, int isRoot) {
+    uint32_t groupMark = validator->groupCount;
+    uint32_t childMark = validator->childCount;
+    uint32_t pendingMark = validator->pendingCount;
+    size_t contentStart = isRoot ? start : start + 1;
+    size_t contentEnd = isRoot ? start + length : start + length - 1;
+    long long delta = old == NO_GROUP ? 0 : (long long) length - (long long) validator->groups[old].length;
+
+    // Reusable children of `old`, visited in order: next child index and its old start.
+    uint32_t oldChildCount = old == NO_GROUP ? 0 : validator->groups[old].childCount;
+    uint32_t nextChild = 0;
+    size_t oldCursor = contentStart;
+    size_t reuseStart = SIZE_MAX;
+    uint32_t reuseGroup = NO_GROUP;
+
+    GrowStack frames; // (group, pending mark, end of the last child) per open group
+    grow_stack_init(&frames);
+    uint32_t top = incremental_new_group(validator, 0, (uint32_t) start);
+    int ok = top != NO_GROUP && grow_stack_push(&frames, (int) top) &&
+             grow_stack_push(&frames, (int) validator->pendingCount) && grow_stack_push(&frames, (int) contentStart);
+    size_t position = contentStart;
+
+    while (ok) {
+        while (reuseGroup == NO_GROUP && nextChild < oldChildCount) {
+            uint32_t child = validator->children[validator->groups[old].firstChild + nextChild++];
+            size_t childStart = oldCursor + validator->groups[child].gap;
+            size_t childEnd = childStart + validator->groups[child].length;
+            oldCursor = childEnd;
+            if (childEnd <= offset) {
+                reuseStart = childStart;
+            } else if (childStart >= offset + deleted) {
+                reuseStart = (size_t) ((long long) childStart + delta);
+            } else {
+                continue;
+            }
+            reuseGroup = child;
+        }
+        size_t limit = reuseGroup != NO_GROUP ? reuseStart : contentEnd;
+
+        for (; ok && position < limit; position++) {
+            unsigned char character = (unsigned char) validator->text[position];
+            if (character == '(') {
+                int cursor = *grow_stack_peek(&frames, 0);
+                uint32_t group = incremental_new_group(validator, (uint32_t) (position - (size_t) cursor),
+                                                       (uint32_t) position);
+                ok = group != NO_GROUP && grow_stack_push(&frames, (int) group) &&
+                     grow_stack_push(&frames, (int) validator->pendingCount) &&
+                     grow_stack_push(&frames, (int) position + 1);
+            } else if (character == ')') {
+                if (frames.count == 3) {
+                    ok = 0; // closes the group being re-scanned
+                    break;
+                }
+                frames.count--;
+                uint32_t mark = (uint32_t) grow_stack_pop(&frames);
+                uint32_t group = (uint32_t) grow_stack_pop(&frames);
+                ok = incremental_close_group(validator, group, mark, position + 1) &&
+                     incremental_push_pending(validator, group);
+                *grow_stack_peek(&frames, 0) = (int) position + 1;
+            } else if (!isspace(character)) {
+                ParenGroup *open = &validator->groups[*grow_stack_peek(&frames, 2)];
+                open->items++;
+                if (isalpha(character)) open->alpha++;
+            }
+        }
+        if (!ok || reuseGroup == NO_GROUP) break;
+
+        // Jump over the untouched child; it joins whichever group is open here.
+        int *cursor = grow_stack_peek(&frames, 0);
+        validator->groups[reuseGroup].gap = (uint32_t) (reuseStart - (size_t) *cursor);
+        position = reuseStart + validator->groups[reuseGroup].length;
+        *cursor = (int) position;
+        validator->rescannedBytes -= (long long) validator->groups[reuseGroup].length;
+        ok = incremental_push_pending(validator, reuseGroup);
+        reuseGroup = NO_GROUP;
+    }
+
+    ok = ok && frames.count == 3 && incremental_close_group(validator, top, pendingMark, start + length);
+    validator->rescannedBytes += (long long) length;
+    grow_stack_free(&frames);
+    if (ok) return top;
+
+    validator->groupCount = groupMark;
+    validator->childCount = childMark;
+    validator->pendingCount = pendingMark;
+    return NO_GROUP;
+}
+
+static void incremental_rebuild(IncrementalValidator *validator) {
+    validator->groupCount = 0;
+    validator->childCount = 0;
+    validator->pendingCount = 0;
+    validator->siblingSums.used = 0;
+    validator->rescannedBytes = 0;
+    validator->root = incremental_rescan(validator, NO_GROUP, 0, validator->length, 0, 0, 1);
+    validator->rootAlpha = 0;
+    if (validator->root == NO_GROUP) return;
+
+    const ParenGroup *root = &validator->groups[validator->root];
+    for (uint32_t i = 0; i < root->childCount; i++) {
+        validator->rootAlpha += validator->groups[validator->children[root->firstChild + i]].alpha;
+    }
+}
+
+// Returns 0 when the document is longer than INCREMENTAL_MAX_LENGTH or memory ran out.
+int incremental_validator_init(IncrementalValidator *validator, const char input[]) {
+    memset(validator, 0, sizeof(*validator));
+    validator->length = strlen(input);
+    if (validator->length > INCREMENTAL_MAX_LENGTH) return 0;
+    validator->capacity = validator->length + 1;
+    validator->text = (char *) malloc(validator->capacity);
+    if (validator->text == NULL) return 0;
+    memcpy(validator->text, input, validator->length + 1);
+    incremental_rebuild(validator);
+    return 1;
+}
+
+void incremental_validator_free(IncrementalValidator *validator) {
+    free(validator->text);
+    free(validator->groups);
+    free(validator->children);
+    free(validator->pending);
+    sibling_index_pool_free(&validator->siblingSums);
+    memset(validator, 0, sizeof(*validator));
+}
+
+// Same result as a StreamValidator pass over the current text. While the
+// parentheses do not balance there is no group tree and this falls back to
+// exactly that pass.
+int incremental_validator_result(const IncrementalValidator *validator) {
+    if (validator->root == NO_GROUP) {
+        StreamValidator stream;
+        stream_validator_init(&stream);
+        stream_validator_feed(&stream, validator->text, validator->length);
+        int validationResult = stream_validator_finish(&stream);
+        stream_validator_free(&stream);
+        return validationResult;
+    }
+    const ParenGroup *root = &validator->groups[validator->root];
+    if (validator->rootAlpha != 1) return -1;
+    if (root->badGroups > 0) return 3;
+    return (int) root->items;
+}
+
+// First child of `group` whose extent (gap + group) ends after `offset`, or
+// childCount when there is none; *childStart receives where it starts.
+// `cursor` is the group's content start.
+static uint32_t incremental_find_child(const IncrementalValidator *validator, const ParenGroup *group,
+                                       size_t cursor, size_t offset, size_t *childStart) {
+    if (group->siblingIndex != SIBLING_INDEX_NONE) {
+        if (offset < cursor) return group->childCount;
+        size_t before = 0;
+        uint32_t i = sibling_index_find(&validator->siblingSums, group->siblingIndex, group->childCount,
+                                        offset - cursor, &before);
+        if (i < group->childCount) {
+            *childStart = cursor + before + validator->groups[validator->children[group->firstChild + i]].gap;
+        }
+        return i;
+    }
+    for (uint32_t i = 0; i < group->childCount; i++) {
+        const ParenGroup *child = &validator->groups[validator->children[group->firstChild + i]];
+        size_t childEnd = cursor + child->gap + child->length;
+        if (childEnd > offset) {
+            *childStart = cursor + child->gap;
+            return i;
+        }
+        cursor = childEnd;
+    }
+    return group->childCount;
+}
+
+// Replaces `deleted` bytes at `offset` with `inserted`. Returns 1 when a
+// group below the document root was re-scanned, 2 when the whole document
+// was, 0 when the edit is out of range, would make the document longer than
+// INCREMENTAL_MAX_LENGTH, or memory ran out.
+int incremental_validator_edit(IncrementalValidator *validator, size_t offset, size_t deleted,
+                               const char inserted[]) {
+    size_t insertedLength = strlen(inserted);
+    if (offset > validator->length || deleted > validator->length - offset) return 0;
+
+    size_t newLength = validator->length - deleted + insertedLength;
+    if (insertedLength > INCREMENTAL_MAX_LENGTH || newLength > INCREMENTAL_MAX_LENGTH) return 0;
+    if (newLength + 1 > validator->capacity) {
+        size_t newCapacity = validator->capacity * 2 > newLength + 1 ? validator->capacity * 2 : newLength + 1;
+        char *grown = (char *) realloc(validator->text, newCapacity);
+        if (grown == NULL) return 0;
+        validator->text = grown;
+        validator->capacity = newCapacity;
+    }
+    memmove(validator->text + offset + insertedLength, validator->text + offset + deleted,
+            validator->length - offset - deleted + 1);
+    memcpy(validator->text + offset, inserted, insertedLength);
+    validator->length = newLength;
+    validator->rescannedBytes = 0;
+    long long delta = (long long) insertedLength - (long long) deleted;
+
+    if (validator->root == NO_GROUP) {
+        incremental_rebuild(validator);
+        return 2;
+    }
+
+    // Groups whose contents hold the whole edit, from the root down: (group, slot, start).
+    GrowStack path;
+    grow_stack_init(&path);
+    uint32_t group = validator->root;
+    int slot = -1;
+    size_t start = 0;
+    for (;;) {
+        if (!grow_stack_push(&path, (int) group) || !grow_stack_push(&path, slot) ||
+            !grow_stack_push(&path, (int) start)) {
+            break;
+        }
+        const ParenGroup *parent = &validator->groups[group];
+        size_t cursor = group == validator->root ? start : start + 1;
+        size_t childStart = 0;
+        uint32_t i = incremental_find_child(validator, parent, cursor, offset, &childStart);
+        if (i == parent->childCount) break;
+        uint32_t next = validator->children[parent->firstChild + i];
+        if (childStart >= offset || offset + deleted >= childStart + validator->groups[next].length) break;
+        slot = (int) i;
+        start = childStart;
+        group = next;
     }
 
+    // Deepest group first; move outwards while the contents do not balance.
+    for (size_t level = path.count / 3; level-- > 1;) {
+        uint32_t old = (uint32_t) path.items[level * 3];
+        slot = path.items[level * 3 + 1];
+        start = (size_t) path.items[level * 3 + 2];
+        size_t length = (size_t) ((long long) validator->groups[old].length + delta);
+        uint32_t replacement = incremental_rescan(validator, old, start, length, offset, deleted, 0);
+        if (replacement == NO_GROUP) continue;
+
+        ParenGroup *groups = validator->groups;
+        uint32_t parent = (uint32_t) path.items[(level - 1) * 3];
+        groups[replacement].gap = groups[old].gap;
+        validator->children[groups[parent].firstChild + (uint32_t) slot] = replacement;
+        if (level == 1) validator->rootAlpha = validator->rootAlpha - groups[old].alpha + groups[replacement].alpha;
+
+        long long badDelta = (long long) groups[replacement].badGroups - (long long) groups[old].badGroups;
+        for (size_t up = level; up-- > 0;) {
+            ParenGroup *ancestor = &groups[path.items[up * 3]];
+            ancestor->length = (uint32_t) ((long long) ancestor->length + delta);
+            ancestor->badGroups = (uint32_t) ((long long) ancestor->badGroups + badDelta);
+            if (ancestor->siblingIndex != SIBLING_INDEX_NONE) {
+                sibling_index_add(&validator->siblingSums, ancestor->siblingIndex, ancestor->childCount,
+                                  (uint32_t) path.items[(up + 1) * 3 + 1], delta);
+            }
+        }
+        grow_stack_free(&path);
+        return 1;
+    }
+    grow_stack_free(&path);
+
+    uint32_t old = validator->root;
+    validator->root = incremental_rescan(validator, old, 0, validator->length, offset, deleted, 1);
+    validator->rootAlpha = 0;
+    if (validator->root != NO_GROUP) {
+        const ParenGroup *root = &validator->groups[validator->root];
+        for (uint32_t i = 0; i < root->childCount; i++) {
+            validator->rootAlpha += validator->groups[validator->children[root->firstChild + i]].alpha;
+        }
+    }
+    return 2;
+}
+
+static double elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) + (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double throughput_mb(long long bytes, double seconds) {
+    return seconds > 0 ? (double) bytes / (1024.0 * 1024.0) / seconds : 0.0;
+}
+
+void print_validation_result(int validationResult) {
     if (validationResult == -1) {
         printf("\nOutput: ERROR\n");
     } else if (validationResult < 2) {
@@ -133,5 +681,368 @@ int main(void) {
     } else if (validationResult > 2) {
         printf("\nOutput: FALSE\n");
     }
+}
+
+int validate_three_pass(const char input[]) {
+    int cursor = 0;
+    int validationResult = -1;
+
+    if (validate_parentheses(input, &cursor) && validate_root_label(input, &cursor)) {
+        cursor = 0;
+        validationResult = validate_tree(input, &cursor, STATUS_ROOT);
+    }
+    return validationResult;
+}
+
+int run_stream_mode(const char *path) {
+    FILE *fp = (path != NULL) ? fopen(path, "rb") : stdin;
+    if (fp == NULL) {
+        printf("file open fail: %s\n", path);
+        return 1;
+    }
+
+    char *chunk = (char *) malloc(STREAM_CHUNK_SIZE);
+    StreamValidator validator;
+    stream_validator_init(&validator);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    size_t length;
+    while ((length = fread(chunk, 1, STREAM_CHUNK_SIZE, fp)) > 0) {
+        stream_validator_feed(&validator, chunk, length);
+    }
+    int validationResult = stream_validator_finish(&validator);
+    double seconds = elapsed_seconds(&start);
+
+    print_validation_result(validationResult);
+    fprintf(stderr, "single-pass: %lld bytes, %.3f s, %.2f MB/s\n",
+            validator.bytesConsumed, seconds, throughput_mb(validator.bytesConsumed, seconds));
+
+    stream_validator_free(&validator);
+    free(chunk);
+    if (fp != stdin) fclose(fp);
+    return 0;
+}
+
+// Loads the whole file so both validators see the same bytes from memory.
+// The three-pass timing is skipped when validate_tree's recursion would
+// overflow the C stack.
+int run_bench_mode(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        printf("file open fail: %s\n", path);
+        return 1;
+    }
+    long long size = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) size = ftell(fp);
+    if (size < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        printf("file read fail: %s\n", path);
+        fclose(fp);
+        return 1;
+    }
+    char *input = (char *) malloc((size_t) size + 1);
+    if (input == NULL) {
+        printf("out of memory\n");
+        fclose(fp);
+        return 1;
+    }
+    size_t readSize = fread(input, 1, (size_t) size, fp);
+    input[readSize] = '\0';
+    fclose(fp);
+
+    struct timespec start;
+    long long maxDepth = sexpr_max_depth(input, readSize);
+    if (maxDepth <= RECURSIVE_BENCH_DEPTH_LIMIT) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int threePassResult = validate_three_pass(input);
+        double threePassSeconds = elapsed_seconds(&start);
+        printf("three-pass : result %d, %.3f s, %.2f MB/s\n",
+               threePassResult, threePassSeconds, throughput_mb((long long) readSize, threePassSeconds));
+    } else {
+        printf("three-pass : skipped (depth %lld > %d)\n", maxDepth, RECURSIVE_BENCH_DEPTH_LIMIT);
+    }
+
+    static const struct {
+        const char *name;
+        SexprClassifier classify;
+    } classifiers[] = {
+        {"scalar", sexpr_classify_scalar},
+        {NULL, sexpr_classify_simd},
+    };
+
+    for (int c = 0; c < 2; c++) {
+        const char *name = classifiers[c].name ? classifiers[c].name : sexpr_classify_simd_name();
+        SexprClassifier classify = classifiers[c].classify;
+
+        // Classifier alone, so its share of the fused pass is visible.
+        uint64_t checksum = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t offset = 0; offset < readSize; offset += SEXPR_BLOCK) {
+            SexprMasks masks;
+            classify(input + offset, readSize - offset < SEXPR_BLOCK ? readSize - offset : SEXPR_BLOCK, &masks);
+            checksum += masks.open ^ masks.close ^ masks.space ^ masks.label;
+        }
+        double classifySeconds = elapsed_seconds(&start);
+
+        StreamValidator validator;
+        stream_validator_init(&validator);
+        validator.classify = classify;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t offset = 0; offset < readSize; offset += STREAM_CHUNK_SIZE) {
+            size_t length = readSize - offset < STREAM_CHUNK_SIZE ? readSize - offset : STREAM_CHUNK_SIZE;
+            stream_validator_feed(&validator, input + offset, length);
+        }
+        int singlePassResult = stream_validator_finish(&validator);
+        double singlePassSeconds = elapsed_seconds(&start);
+
+        printf("classify %-6s: %.3f s, %.2f MB/s (checksum %llx)\n", name, classifySeconds,
+               throughput_mb((long long) readSize, classifySeconds), (unsigned long long) checksum);
+        printf("single-pass %-6s: result %d, %.3f s, %.2f MB/s\n", name, singlePassResult, singlePassSeconds,
+               throughput_mb((long long) readSize, singlePassSeconds));
+        stream_validator_free(&validator);
+    }
+
+    free(input);
+    return 0;
+}
+
+// Times validate_tree against validate_tree_iterative on one file; the
+// recursive one is skipped when the nesting would overflow the C stack.
+int run_parse_bench_mode(const char *path) {
+    size_t size = 0;
+    char *input = line_batch_load_file(path, &size);
+    if (input == NULL) return 1;
+    long long maxDepth = sexpr_max_depth(input, size);
+    struct timespec start;
+
+    printf("input: %zu bytes, max depth %lld\n", size, maxDepth);
+    if (maxDepth <= RECURSIVE_BENCH_DEPTH_LIMIT) {
+        int cursor = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int recursiveResult = validate_tree(input, &cursor, STATUS_ROOT);
+        double seconds = elapsed_seconds(&start);
+        printf("recursive: result %d, %.3f s, %.2f MB/s\n", recursiveResult, seconds,
+               throughput_mb((long long) size, seconds));
+    } else {
+        printf("recursive: skipped (depth > %d)\n", RECURSIVE_BENCH_DEPTH_LIMIT);
+    }
+
+    size_t cursor = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int iterativeResult = validate_tree_iterative(input, &cursor);
+    double seconds = elapsed_seconds(&start);
+    printf("iterative: result %d, %.3f s, %.2f MB/s\n", iterativeResult, seconds,
+           throughput_mb((long long) size, seconds));
+
+    free(input);
+    return 0;
+}
+
+static void *batch_create_validator(void) {
+    StreamValidator *validator = (StreamValidator *) malloc(sizeof(StreamValidator));
+    if (validator == NULL) return NULL;
+    stream_validator_init(validator);
+    if (validator->childCounts == NULL) {
+        free(validator);
+        return NULL;
+    }
+    return validator;
+}
+
+static void batch_destroy_validator(void *scratch) {
+    stream_validator_free((StreamValidator *) scratch);
+    free(scratch);
+}
+
+// Same verdicts as print_validation_result; the interactive path prints
+// nothing for a result of 2 (two stray atoms outside the root list), which
+// batch output reports as ERROR so every input line gets a result line.
+static int batch_result(int validationResult) {
+    if (validationResult == -1 || validationResult == 2) return BATCH_ERROR;
+    return validationResult < 2 ? BATCH_TRUE : BATCH_FALSE;
+}
+
+static int batch_validate_line(char line[], size_t length, void *scratch) {
+    StreamValidator *validator = (StreamValidator *) scratch;
+    stream_validator_reset(validator);
+    stream_validator_feed(validator, line, length);
+    return batch_result(stream_validator_finish(validator));
+}
+
+// Reads a document line, then edit lines "offset deleted text" (text is the
+// rest of the line after one space and may be empty); prints one
+// TRUE/FALSE/ERROR line for the document and after every edit.
+int run_incremental_mode(FILE *fp) {
+    static const char *const labels[] = {"TRUE", "FALSE", "ERROR"};
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLength = getline(&line, &lineCapacity, fp);
+    if (lineLength < 0) {
+        free(line);
+        return 1;
+    }
+    if (lineLength > 0 && line[lineLength - 1] == '\n') line[--lineLength] = '\0';
+
+    IncrementalValidator validator;
+    if (!incremental_validator_init(&validator, line)) {
+        printf("ERROR\n");
+        free(line);
+        return 1;
+    }
+    printf("%s\n", labels[batch_result(incremental_validator_result(&validator))]);
+
+    while ((lineLength = getline(&line, &lineCapacity, fp)) >= 0) {
+        if (lineLength > 0 && line[lineLength - 1] == '\n') line[--lineLength] = '\0';
+        char *cursor = line;
+        unsigned long offset = strtoul(cursor, &cursor, 10);
+        unsigned long deleted = strtoul(cursor, &cursor, 10);
+        if (*cursor == ' ') cursor++;
+
+        int rescanned = incremental_validator_edit(&validator, offset, deleted, cursor);
+        if (rescanned == 0) {
+            printf("ERROR\n");
+            continue;
+        }
+        printf("%s\n", labels[batch_result(incremental_validator_result(&validator))]);
+        fprintf(stderr, "%s re-scan: %lld bytes\n", rescanned == 1 ? "group" : "document",
+                validator.rescannedBytes);
+    }
+    incremental_validator_free(&validator);
+    free(line);
+    return 0;
+}
+
+static uint64_t bench_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Applies random edits (swap a letter, add a "(Q)" group after a letter,
+// remove one again) incrementally and compares the time per edit with a
+// full single-pass validation; every so often the incremental result is
+// checked against that full pass.
+int run_incremental_bench_mode(const char *path, int editCount) {
+    size_t size = 0;
+    char *input = line_batch_load_file(path, &size);
+    if (input == NULL) return 1;
+    if (editCount < 1) editCount = 10000;
+
+    struct timespec start;
+    StreamValidator stream;
+    stream_validator_init(&stream);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    stream_validator_feed(&stream, input, size);
+    int fullResult = stream_validator_finish(&stream);
+    double fullSeconds = elapsed_seconds(&start);
+
+    IncrementalValidator validator;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!incremental_validator_init(&validator, input)) {
+        printf("ERROR\n");
+        stream_validator_free(&stream);
+        free(input);
+        return 1;
+    }
+    printf("input: %zu bytes, %u groups; single-pass %.4f s (result %d), initial build %.4f s (result %d)\n", size,
+           validator.groupCount, fullSeconds, fullResult, elapsed_seconds(&start),
+           incremental_validator_result(&validator));
+    free(input);
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    long long rescanned = 0, insertedGroups = 0;
+    int applied = 0, groupEdits = 0, checks = 0, failures = 0;
+    double editSeconds = 0.0;
+    for (int e = 0; e < editCount; e++) {
+        // Finding the next letter is not part of the timed edit.
+        size_t offset = (size_t) (bench_random(&state) % (validator.length ? validator.length : 1));
+        while (offset < validator.length && !isalpha((unsigned char) validator.text[offset])) offset++;
+        if (offset >= validator.length) continue;
+
+        char replacement[2] = {(char) ('A' + bench_random(&state) % 26), '\0'};
+        int kind = (int) (bench_random(&state) % 3);
+        size_t deleted = 1;
+        const char *inserted = replacement;
+        if (kind == 1) {
+            offset++;
+            deleted = 0;
+            inserted = " (Q)";
+            insertedGroups++;
+        } else if (kind == 2 && insertedGroups > 0 && offset >= 2 && offset + 2 <= validator.length &&
+                   memcmp(validator.text + offset - 2, " (Q)", 4) == 0) {
+            offset -= 2;
+            deleted = 4;
+            inserted = "";
+            insertedGroups--;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int result = incremental_validator_edit(&validator, offset, deleted, inserted);
+        editSeconds += elapsed_seconds(&start);
+        if (result == 0) {
+            failures++;
+            continue;
+        }
+        applied++;
+        groupEdits += result == 1;
+        rescanned += validator.rescannedBytes;
+
+        if (e % (editCount / 20 + 1) == 0) {
+            stream_validator_reset(&stream);
+            stream_validator_feed(&stream, validator.text, validator.length);
+            failures += batch_result(stream_validator_finish(&stream)) !=
+                        batch_result(incremental_validator_result(&validator));
+            checks++;
+        }
+    }
+    double perEdit = applied ? editSeconds / applied : 0.0;
+    printf("%d edits: %d within a group, %.2f us/edit, %.1f bytes re-scanned/edit, %u groups allocated\n", applied,
+           groupEdits, perEdit * 1e6, applied ? (double) rescanned / applied : 0.0, validator.groupCount);
+    printf("full single-pass would cost %.1f us/edit (%.0fx)\n", fullSeconds * 1e6,
+           perEdit > 0 ? fullSeconds / perEdit : 0.0);
+    printf("checked %d snapshots against a full pass: %s\n", checks, failures ? "MISMATCH" : "ok");
+
+    incremental_validator_free(&validator);
+    stream_validator_free(&stream);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--stream") == 0) {
+        return run_stream_mode(argc >= 3 ? argv[2] : NULL);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--bench") == 0) {
+        return run_bench_mode(argv[2]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--bench-parse") == 0) {
+        return run_parse_bench_mode(argv[2]);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--incremental") == 0) {
+        return run_incremental_mode(stdin);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--bench-incremental") == 0) {
+        return run_incremental_bench_mode(argv[2], argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--batch") == 0) {
+        LineBatchValidator validator = {batch_create_validator, batch_destroy_validator, batch_validate_line};
+        return run_line_batch(argv[2], argc >= 4 ? atoi(argv[3]) : 0, &validator, stdout);
+    }
+
+    char buffer[256];
+    printf("Input:");
+    scanf("%[^\n]", buffer);
+
+    int cursor = 0;
+
+    while (buffer[cursor] != '\0') {
+        if (buffer[cursor] == '\n') {
+            printf("\nOutput: ERROR\n");
+            return 0;
+        }
+        cursor++;
+    }
+
+    print_validation_result(validate_three_pass(buffer));
     return 0;
 }
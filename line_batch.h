@@ -0,0 +1,262 @@
+#ifndef LINE_BATCH_H
+#define LINE_BATCH_H
+
+// Batch driver shared by hw-01.c and subject1_5.c: validates a file of
+// newline-delimited expressions on a pool of pthreads and writes one
+// TRUE/FALSE/ERROR line per input line, in input order.
+//
+// The file is loaded once and cut into blocks that end on a line boundary.
+// Workers claim blocks with an atomic counter, so a few long lines cannot
+// stall one thread while others sit idle. Each block keeps one result byte
+// per line; the main thread prints the blocks in order after the join.
+// If a result cannot be stored the whole run fails, since printing the
+// other blocks would shift every later verdict onto the wrong line.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LINE_BATCH_BLOCKS_PER_THREAD 16
+
+enum {
+    BATCH_TRUE,
+    BATCH_FALSE,
+    BATCH_ERROR
+};
+
+typedef struct {
+    // Optional per-thread state (e.g. a reusable validator); may be NULL.
+    // create_scratch returns NULL when it runs out of memory.
+    void *(*create_scratch)(void);
+    void (*destroy_scratch)(void *scratch);
+    // line is NUL-terminated in place; returns BATCH_TRUE/FALSE/ERROR.
+    int (*validate_line)(char line[], size_t length, void *scratch);
+} LineBatchValidator;
+
+typedef struct {
+    char *start;
+    char *end;
+    unsigned char *results;
+    size_t lineCount;
+    size_t capacity;
+} LineBatchBlock;
+
+typedef struct {
+    long long lines;
+    long long trueCount;
+    long long falseCount;
+    long long errorCount;
+    long long blocks;
+} LineBatchCounters;
+
+typedef struct {
+    const LineBatchValidator *validator;
+    LineBatchBlock *blocks;
+    size_t blockCount;
+    size_t nextBlock;
+    int failed;     // set when a block ran out of memory for its results
+} LineBatchJob;
+
+typedef struct {
+    LineBatchJob *job;
+    LineBatchCounters counters;
+} LineBatchWorker;
+
+static int line_batch_append_result(LineBatchBlock *block, unsigned char result) {
+    if (block->lineCount == block->capacity) {
+        size_t newCapacity = block->capacity ? block->capacity * 2 : 1024;
+        unsigned char *grown = (unsigned char *) realloc(block->results, newCapacity);
+        if (grown == NULL) return 0;
+        block->results = grown;
+        block->capacity = newCapacity;
+    }
+    block->results[block->lineCount++] = result;
+    return 1;
+}
+
+// Returns 0 if a result could not be stored; the block is then incomplete.
+static int line_batch_process_block(const LineBatchValidator *validator, LineBatchBlock *block,
+                                    void *scratch, LineBatchCounters *counters) {
+    char *cursor = block->start;
+
+    while (cursor < block->end) {
+        char *newline = (char *) memchr(cursor, '\n', (size_t) (block->end - cursor));
+        char *lineEnd = (newline != NULL) ? newline : block->end;
+        size_t length = (size_t) (lineEnd - cursor);
+        if (length > 0 && cursor[length - 1] == '\r') length--;
+        cursor[length] = '\0';
+
+        int result = validator->validate_line(cursor, length, scratch);
+        if (!line_batch_append_result(block, (unsigned char) result)) return 0;
+
+        counters->lines++;
+        if (result == BATCH_TRUE) counters->trueCount++;
+        else if (result == BATCH_FALSE) counters->falseCount++;
+        else counters->errorCount++;
+
+        cursor = lineEnd + 1;
+    }
+    counters->blocks++;
+    return 1;
+}
+
+static void *line_batch_worker(void *argument) {
+    LineBatchWorker *worker = (LineBatchWorker *) argument;
+    LineBatchJob *job = worker->job;
+    void *scratch = job->validator->create_scratch ? job->validator->create_scratch() : NULL;
+    if (job->validator->create_scratch && scratch == NULL) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    for (;;) {
+        size_t index = __atomic_fetch_add(&job->nextBlock, 1, __ATOMIC_RELAXED);
+        if (index >= job->blockCount || __atomic_load_n(&job->failed, __ATOMIC_RELAXED)) break;
+        if (!line_batch_process_block(job->validator, &job->blocks[index], scratch, &worker->counters)) {
+            __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+
+    if (job->validator->destroy_scratch) job->validator->destroy_scratch(scratch);
+    return NULL;
+}
+
+static char *line_batch_load_file(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        printf("file open fail: %s\n", path);
+        return NULL;
+    }
+    long fileSize = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) fileSize = ftell(fp);
+    if (fileSize < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        printf("file read fail: %s\n", path);
+        fclose(fp);
+        return NULL;
+    }
+
+    // One spare byte so the last line can be NUL-terminated in place.
+    char *buffer = (char *) malloc((size_t) fileSize + 1);
+    if (buffer == NULL) {
+        printf("out of memory\n");
+        fclose(fp);
+        return NULL;
+    }
+    *size = fread(buffer, 1, (size_t) fileSize, fp);
+    buffer[*size] = '\0';
+    fclose(fp);
+    return buffer;
+}
+
+static size_t line_batch_split(char *buffer, size_t size, LineBatchBlock *blocks, size_t maxBlocks) {
+    size_t blockCount = 0;
+    size_t target = size / maxBlocks + 1;
+    char *cursor = buffer;
+    char *bufferEnd = buffer + size;
+
+    while (cursor < bufferEnd && blockCount < maxBlocks) {
+        char *end = cursor + target;
+        if (end >= bufferEnd || blockCount == maxBlocks - 1) {
+            end = bufferEnd;
+        } else {
+            char *newline = (char *) memchr(end, '\n', (size_t) (bufferEnd - end));
+            end = (newline != NULL) ? newline + 1 : bufferEnd;
+        }
+        memset(&blocks[blockCount], 0, sizeof(LineBatchBlock));
+        blocks[blockCount].start = cursor;
+        blocks[blockCount].end = end;
+        blockCount++;
+        cursor = end;
+    }
+    return blockCount;
+}
+
+static int line_batch_default_threads(void) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (int) online : 1;
+}
+
+static int run_line_batch(const char *path, int threadCount, const LineBatchValidator *validator, FILE *out) {
+    static const char *const labels[] = {"TRUE", "FALSE", "ERROR"};
+    size_t size = 0;
+    char *buffer = line_batch_load_file(path, &size);
+    if (buffer == NULL) return 1;
+    if (threadCount < 1) threadCount = line_batch_default_threads();
+
+    struct timespec start, finish;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    size_t maxBlocks = (size_t) threadCount * LINE_BATCH_BLOCKS_PER_THREAD;
+    LineBatchBlock *blocks = (LineBatchBlock *) malloc(sizeof(LineBatchBlock) * maxBlocks);
+    pthread_t *threads = (pthread_t *) malloc(sizeof(pthread_t) * (size_t) threadCount);
+    LineBatchWorker *workers = (LineBatchWorker *) calloc((size_t) threadCount, sizeof(LineBatchWorker));
+    if (blocks == NULL || threads == NULL || workers == NULL) {
+        fprintf(stderr, "out of memory\n");
+        free(workers);
+        free(threads);
+        free(blocks);
+        free(buffer);
+        return 1;
+    }
+    LineBatchJob job = {validator, blocks, line_batch_split(buffer, size, blocks, maxBlocks), 0, 0};
+
+    // Blocks are claimed from a shared counter, so the threads that did
+    // start cover the whole file; with none, the main thread does it.
+    int started = 0;
+    for (int i = 0; i < threadCount; i++) {
+        workers[i].job = &job;
+        if (pthread_create(&threads[started], NULL, line_batch_worker, &workers[i]) == 0) started++;
+    }
+    if (started == 0) line_batch_worker(&workers[0]);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    double seconds = (double) (finish.tv_sec - start.tv_sec) + (double) (finish.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (job.failed) {
+        fprintf(stderr, "out of memory: results were not printed\n");
+        for (size_t b = 0; b < job.blockCount; b++) free(blocks[b].results);
+        free(workers);
+        free(threads);
+        free(blocks);
+        free(buffer);
+        return 1;
+    }
+
+    for (size_t b = 0; b < job.blockCount; b++) {
+        for (size_t i = 0; i < blocks[b].lineCount; i++) {
+            fputs(labels[blocks[b].results[i]], out);
+            fputc('\n', out);
+        }
+        free(blocks[b].results);
+    }
+    fflush(out);
+
+    LineBatchCounters total = {0, 0, 0, 0, 0};
+    for (int i = 0; i < threadCount; i++) {
+        LineBatchCounters *c = &workers[i].counters;
+        fprintf(stderr, "thread %2d: %lld blocks, %lld lines (TRUE %lld, FALSE %lld, ERROR %lld)\n",
+                i, c->blocks, c->lines, c->trueCount, c->falseCount, c->errorCount);
+        total.lines += c->lines;
+        total.trueCount += c->trueCount;
+        total.falseCount += c->falseCount;
+        total.errorCount += c->errorCount;
+    }
+    fprintf(stderr, "total: %lld lines (TRUE %lld, FALSE %lld, ERROR %lld) in %.3f s, %.0f lines/s\n",
+            total.lines, total.trueCount, total.falseCount, total.errorCount, seconds,
+            seconds > 0 ? (double) total.lines / seconds : 0.0);
+
+    free(workers);
+    free(threads);
+    free(blocks);
+    free(buffer);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef PERF_COUNTER_H
+#define PERF_COUNTER_H
+
+// Hardware cache-miss counter for the search benchmarks, using
+// perf_event_open on Linux. It counts this process's user-space misses
+// only. Containers, VMs and kernels with perf_event_paranoid > 2 often
+// refuse the event; the counter then reports -1 and callers print "n/a".
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <string.h>
+
+typedef struct {
+    int fd;     // -1 when the event is unavailable
+} PerfCounter;
+
+static inline void perf_counter_open_cache_misses(PerfCounter *counter) {
+    counter->fd = -1;
+#if defined(__linux__) && defined(SYS_perf_event_open)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    counter->fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+static inline void perf_counter_start(PerfCounter *counter) {
+#if defined(__linux__)
+    if (counter->fd < 0) return;
+    ioctl(counter->fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(counter->fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+// Misses since perf_counter_start, or -1 when unavailable.
+static inline long long perf_counter_stop(PerfCounter *counter) {
+#if defined(__linux__)
+    long long count = 0;
+    if (counter->fd < 0) return -1;
+    ioctl(counter->fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(counter->fd, &count, sizeof(count)) != (ssize_t) sizeof(count)) return -1;
+    return count;
+#else
+    (void) counter;
+    return -1;
+#endif
+}
+
+static inline void perf_counter_close(PerfCounter *counter) {
+#if defined(__linux__)
+    if (counter->fd >= 0) close(counter->fd);
+#endif
+    counter->fd = -1;
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef SEXPR_CLASSIFY_H
+#define SEXPR_CLASSIFY_H
+
+// Structural character classifier shared by the S-expression tokenizers
+// (hw-01.c, subject2.c, subject3.c). Each call classifies up to 64 bytes
+// and returns one bitmask per class, bit i standing for block[i]:
+//   open  '('            close ')'
+//   space isspace() in the C locale (' ', '\t' .. '\r')
+//   label isalpha() in the C locale ('A'-'Z', 'a'-'z')
+// Full 64-byte blocks use AVX2 or SSE2 when the compiler targets them
+// (-mavx2 / -march=native); short tails and other targets use the scalar
+// loop, which gives identical masks.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SEXPR_BLOCK 64
+
+typedef struct {
+    uint64_t open;
+    uint64_t close;
+    uint64_t space;
+    uint64_t label;
+} SexprMasks;
+
+typedef void (*SexprClassifier)(const char block[], size_t length, SexprMasks *masks);
+
+static inline void sexpr_classify_scalar(const char block[], size_t length, SexprMasks *masks) {
+    SexprMasks result = {0, 0, 0, 0};
+
+    for (size_t i = 0; i < length; i++) {
+        unsigned char character = (unsigned char) block[i];
+        uint64_t bit = (uint64_t) 1 << i;
+
+        if (character == '(') {
+            result.open |= bit;
+        } else if (character == ')') {
+            result.close |= bit;
+        } else if (character == ' ' || (character >= '\t' && character <= '\r')) {
+            result.space |= bit;
+        } else if ((unsigned char) ((character | 0x20) - 'a') < 26) {
+            result.label |= bit;
+        }
+    }
+    *masks = result;
+}
+
+#if defined(__AVX2__)
+
+static inline void sexpr_classify_32(const char block[], int shift, SexprMasks *masks) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i *) block);
+    __m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+    // Signed compares: bytes >= 0x80 are negative and fall outside both ranges.
+    __m256i space = _mm256_or_si256(
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+        _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('\t' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), bytes)));
+    __m256i label = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+
+    masks->open |= (uint64_t) (uint32_t) _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('('))) << shift;
+    masks->close |= (uint64_t) (uint32_t) _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(')'))) << shift;
+    masks->space |= (uint64_t) (uint32_t) _mm256_movemask_epi8(space) << shift;
+    masks->label |= (uint64_t) (uint32_t) _mm256_movemask_epi8(label) << shift;
+}
+
+#elif defined(__SSE2__)
+
+static inline void sexpr_classify_16(const char block[], int shift, SexprMasks *masks) {
+    __m128i bytes = _mm_loadu_si128((const __m128i *) block);
+    __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    // Signed compares: bytes >= 0x80 are negative and fall outside both ranges.
+    __m128i space = _mm_or_si128(
+        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+        _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('\t' - 1)),
+                      _mm_cmplt_epi8(bytes, _mm_set1_epi8('\r' + 1))));
+    __m128i label = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+
+    masks->open |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('('))) << shift;
+    masks->close |= (uint64_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(')'))) << shift;
+    masks->space |= (uint64_t) _mm_movemask_epi8(space) << shift;
+    masks->label |= (uint64_t) _mm_movemask_epi8(label) << shift;
+}
+
+#endif
+
+static inline void sexpr_classify_simd(const char block[], size_t length, SexprMasks *masks) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    if (length == SEXPR_BLOCK) {
+        SexprMasks result = {0, 0, 0, 0};
+#if defined(__AVX2__)
+        sexpr_classify_32(block, 0, &result);
+        sexpr_classify_32(block + 32, 32, &result);
+#else
+        for (int offset = 0; offset < SEXPR_BLOCK; offset += 16) {
+            sexpr_classify_16(block + offset, offset, &result);
+        }
+#endif
+        *masks = result;
+        return;
+    }
+#endif
+    sexpr_classify_scalar(block, length, masks);
+}
+
+static inline const char *sexpr_classify_simd_name(void) {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+// Masks for a whole buffer, for parsers that jump around with "find the
+// next label / ')' / non-space at or after i" instead of streaming.
+typedef struct {
+    SexprMasks *blocks;
+    size_t blockCount;
+    size_t length;
+} SexprIndex;
+
+typedef enum {
+    SEXPR_FIND_LABEL,
+    SEXPR_FIND_CLOSE,
+    SEXPR_FIND_NONSPACE
+} SexprFind;
+
+static inline int sexpr_index_build(SexprIndex *index, const char input[], size_t length,
+                                    SexprClassifier classify) {
+    index->length = length;
+    index->blockCount = (length + SEXPR_BLOCK - 1) / SEXPR_BLOCK;
+    index->blocks = (SexprMasks *) malloc(sizeof(SexprMasks) * (index->blockCount ? index->blockCount : 1));
+    if (index->blocks == NULL) return 0;
+
+    for (size_t b = 0; b < index->blockCount; b++) {
+        size_t offset = b * SEXPR_BLOCK;
+        size_t blockLength = length - offset < SEXPR_BLOCK ? length - offset : SEXPR_BLOCK;
+        classify(input + offset, blockLength, &index->blocks[b]);
+    }
+    return 1;
+}
+
+static inline void sexpr_index_free(SexprIndex *index) {
+    free(index->blocks);
+    index->blocks = NULL;
+    index->blockCount = 0;
+}
+
+static inline uint64_t sexpr_select_mask(const SexprIndex *index, size_t block, SexprFind find) {
+    const SexprMasks *masks = &index->blocks[block];
+
+    if (find == SEXPR_FIND_LABEL) return masks->label;
+    if (find == SEXPR_FIND_CLOSE) return masks->close;
+
+    size_t valid = index->length - block * SEXPR_BLOCK;
+    uint64_t validMask = valid >= SEXPR_BLOCK ? ~(uint64_t) 0 : (((uint64_t) 1 << valid) - 1);
+    return ~masks->space & validMask;
+}
+
+// Position of the first byte at or after `from` in the requested class,
+// or index->length when there is none.
+static inline size_t sexpr_find_next(const SexprIndex *index, size_t from, SexprFind find) {
+    if (from >= index->length) return index->length;
+
+    size_t block = from / SEXPR_BLOCK;
+    uint64_t mask = sexpr_select_mask(index, block, find) & (~(uint64_t) 0 << (from % SEXPR_BLOCK));
+
+    while (mask == 0) {
+        if (++block >= index->blockCount) return index->length;
+        mask = sexpr_select_mask(index, block, find);
+    }
+    return block * SEXPR_BLOCK + (size_t) __builtin_ctzll(mask);
+}
+
+// Deepest parenthesis nesting in input[0..length), ignoring stray ')'.
+// Benchmarks use it to skip recursive parsers that would overflow the stack.
+static inline long long sexpr_max_depth(const char input[], size_t length) {
+    long long depth = 0;
+    long long maxDepth = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        if (input[i] == '(') {
+            if (++depth > maxDepth) maxDepth = depth;
+        } else if (input[i] == ')' && depth > 0) {
+            depth--;
+        }
+    }
+    return maxDepth;
+}
+
+#endif
@@ -0,0 +1,395 @@
+#define _DEFAULT_SOURCE
+
+// Synthetic S-expression corpus and throughput driver for the tree programs
+// (hw-01.c, subject1_5.c, subject2.c, subject3.c).
+//
+//   sexpr_corpus gen SHAPE SIZE [SEED] [--lines]
+//       Writes one tree of about SIZE bytes (K/M/G suffixes allowed) to
+//       stdout, or with --lines many small trees, one per line, for the
+//       --batch modes. SHAPE is balanced, skewed, wide, deep or malformed.
+//       The same arguments always give the same bytes.
+//   sexpr_corpus bench DIR SIZE [BINDIR]
+//       Generates every shape of SIZE into DIR, runs each parser/validator
+//       mode of the programs found in BINDIR (default ".") on it and
+//       prints wall time, MB/s and peak RSS per run.
+//
+// Every tree uses the grammar all four programs read:
+//   tree := LABEL | LABEL " (" tree (" " tree)* ")"
+// wrapped in one outer pair of parentheses, so the root label sits at
+// depth 1 as hw-01.c expects. Labels are single letters.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CORPUS_BUFFER_SIZE (1 << 20)
+#define CORPUS_CALIBRATION_NODES 100000
+#define CORPUS_LINE_NODES 64
+// Roughly one defect per this many emitted bytes in the malformed shape.
+#define CORPUS_DEFECT_INTERVAL 4096
+
+typedef enum {
+    SHAPE_BALANCED,
+    SHAPE_SKEWED,
+    SHAPE_WIDE,
+    SHAPE_DEEP,
+    SHAPE_MALFORMED,
+    SHAPE_COUNT
+} CorpusShape;
+
+static const char *const shape_names[SHAPE_COUNT] = {"balanced", "skewed", "wide", "deep", "malformed"};
+
+typedef struct {
+    FILE *out;           // NULL: count bytes only
+    char *buffer;
+    size_t used;
+    unsigned long long bytes;
+    uint64_t random;
+    unsigned long long labels;
+} CorpusWriter;
+
+// One open child list: bytes of nodes still to hand out and lists left.
+typedef struct {
+    unsigned long long remaining;
+    unsigned long long childrenLeft;
+    int first;
+} CorpusFrame;
+
+static uint64_t corpus_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void corpus_flush(CorpusWriter *writer) {
+    if (writer->out != NULL && writer->used > 0) fwrite(writer->buffer, 1, writer->used, writer->out);
+    writer->used = 0;
+}
+
+static void corpus_put(CorpusWriter *writer, char character) {
+    writer->bytes++;
+    if (writer->out == NULL) return;
+    if (writer->used == CORPUS_BUFFER_SIZE) corpus_flush(writer);
+    writer->buffer[writer->used++] = character;
+}
+
+// The malformed shape passes every structural byte through here: now and
+// then a ')' is dropped or doubled, a label is doubled or a digit appears.
+static void corpus_put_structural(CorpusWriter *writer, CorpusShape shape, char character) {
+    if (shape == SHAPE_MALFORMED && corpus_random(&writer->random) % CORPUS_DEFECT_INTERVAL == 0) {
+        switch (corpus_random(&writer->random) % 4) {
+        case 0:
+            if (character == ')') return;
+            break;
+        case 1:
+            if (character == ')') corpus_put(writer, ')');
+            break;
+        case 2:
+            if (character != ' ' && character != '(' && character != ')') corpus_put(writer, character);
+            break;
+        default:
+            corpus_put(writer, '7');
+            corpus_put(writer, ' ');
+            break;
+        }
+    }
+    corpus_put(writer, character);
+}
+
+// Number of children for a node with `below` descendants.
+static unsigned long long corpus_fan_out(CorpusWriter *writer, CorpusShape shape, unsigned long long below) {
+    unsigned long long fanOut;
+    if (shape == SHAPE_DEEP) {
+        fanOut = 1;
+    } else if (shape == SHAPE_WIDE) {
+        fanOut = 8 + corpus_random(&writer->random) % 249;
+    } else {
+        fanOut = 2;
+    }
+    return fanOut < below ? fanOut : below;
+}
+
+// Size of the next child subtree out of `remaining` nodes for `childrenLeft` children.
+static unsigned long long corpus_split(CorpusWriter *writer, CorpusShape shape, unsigned long long remaining,
+                                       unsigned long long childrenLeft) {
+    if (childrenLeft == 1) return remaining;
+    unsigned long long spare = remaining - childrenLeft; // every child gets at least one node
+    unsigned long long extra;
+    if (shape == SHAPE_SKEWED) {
+        // Left child takes 85-99% of the nodes: long, deep left spines.
+        extra = spare * (85 + corpus_random(&writer->random) % 15) / 100;
+    } else if (shape == SHAPE_WIDE) {
+        unsigned long long even = spare / childrenLeft;
+        extra = even / 2 + (even ? corpus_random(&writer->random) % (even + 1) : 0);
+    } else {
+        extra = (spare + childrenLeft - 1) / childrenLeft;
+    }
+    return 1 + (extra < spare ? extra : spare);
+}
+
+// Writes one tree of exactly `nodes` nodes, inside the outer parentheses.
+// Only the open child lists are kept, so a deep tree needs one frame per
+// level but no recursion.
+static int corpus_write_tree(CorpusWriter *writer, CorpusShape shape, unsigned long long nodes) {
+    size_t capacity = 64, depth = 0;
+    CorpusFrame *frames = (CorpusFrame *) malloc(sizeof(CorpusFrame) * capacity);
+    if (frames == NULL) return 0;
+
+    corpus_put_structural(writer, shape, '(');
+    unsigned long long size = nodes;
+    for (;;) {
+        // Emit the node of `size` nodes and open its child list.
+        corpus_put_structural(writer, shape, (char) ('A' + writer->labels++ % 26));
+        if (size > 1) {
+            if (depth == capacity) {
+                CorpusFrame *grown = (CorpusFrame *) realloc(frames, sizeof(CorpusFrame) * capacity * 2);
+                if (grown == NULL) {
+                    free(frames);
+                    return 0;
+                }
+                frames = grown;
+                capacity *= 2;
+            }
+            frames[depth].remaining = size - 1;
+            frames[depth].childrenLeft = corpus_fan_out(writer, shape, size - 1);
+            frames[depth].first = 1;
+            depth++;
+            corpus_put_structural(writer, shape, ' ');
+            corpus_put_structural(writer, shape, '(');
+        }
+
+        while (depth > 0 && frames[depth - 1].childrenLeft == 0) {
+            corpus_put_structural(writer, shape, ')');
+            depth--;
+        }
+        if (depth == 0) break;
+
+        CorpusFrame *frame = &frames[depth - 1];
+        size = corpus_split(writer, shape, frame->remaining, frame->childrenLeft);
+        frame->remaining -= size;
+        frame->childrenLeft--;
+        if (!frame->first) corpus_put_structural(writer, shape, ' ');
+        frame->first = 0;
+    }
+    corpus_put_structural(writer, shape, ')');
+    free(frames);
+    return 1;
+}
+
+static void corpus_writer_init(CorpusWriter *writer, FILE *out, uint64_t seed) {
+    memset(writer, 0, sizeof(*writer));
+    writer->out = out;
+    writer->random = seed ? seed : 88172645463325252ULL;
+}
+
+// Node count that makes a tree of this shape about `targetBytes` long,
+// measured on a small tree of the same shape.
+static unsigned long long corpus_nodes_for(CorpusShape shape, unsigned long long targetBytes, uint64_t seed) {
+    CorpusWriter counter;
+    corpus_writer_init(&counter, NULL, seed);
+    if (!corpus_write_tree(&counter, shape, CORPUS_CALIBRATION_NODES)) return 1;
+    double bytesPerNode = (double) counter.bytes / CORPUS_CALIBRATION_NODES;
+    unsigned long long nodes = (unsigned long long) ((double) targetBytes / bytesPerNode);
+    return nodes > 0 ? nodes : 1;
+}
+
+static unsigned long long parse_size(const char *text) {
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    switch (*end) {
+    case 'G':
+    case 'g':
+        value <<= 30;
+        break;
+    case 'M':
+    case 'm':
+        value <<= 20;
+        break;
+    case 'K':
+    case 'k':
+        value <<= 10;
+        break;
+    default:
+        break;
+    }
+    return value;
+}
+
+static int parse_shape(const char *name) {
+    for (int shape = 0; shape < SHAPE_COUNT; shape++) {
+        if (strcmp(name, shape_names[shape]) == 0) return shape;
+    }
+    return -1;
+}
+
+// Writes the corpus; returns the number of bytes written, 0 on failure.
+unsigned long long corpus_generate(FILE *out, CorpusShape shape, unsigned long long targetBytes, uint64_t seed,
+                                   int lines) {
+    CorpusWriter writer;
+    corpus_writer_init(&writer, out, seed);
+    writer.buffer = (char *) malloc(CORPUS_BUFFER_SIZE);
+    if (writer.buffer == NULL) return 0;
+
+    int ok = 1;
+    if (lines) {
+        while (ok && writer.bytes < targetBytes) {
+            ok = corpus_write_tree(&writer, shape, 1 + corpus_random(&writer.random) % CORPUS_LINE_NODES);
+            corpus_put(&writer, '\n');
+        }
+    } else {
+        ok = corpus_write_tree(&writer, shape, corpus_nodes_for(shape, targetBytes, seed));
+        corpus_put(&writer, '\n');
+    }
+    corpus_flush(&writer);
+    free(writer.buffer);
+    return ok ? writer.bytes : 0;
+}
+
+// One program run of the benchmark; "%s" in an argument is the input path.
+typedef struct {
+    const char *program;
+    const char *arguments[3];
+    int inputOnStdin;
+    int lines;           // reads the one-tree-per-line corpus
+} BenchRun;
+
+static const BenchRun bench_runs[] = {
+    {"hw-01", {"--stream", "%s", NULL}, 0, 0},
+    {"hw-01", {"--bench-parse", "%s", NULL}, 0, 0},
+    {"hw-01", {"--batch", "%s", NULL}, 0, 1},
+    {"subject1_5", {"--parallel", "%s", NULL}, 0, 0},
+    {"subject1_5", {"--bench-parse", "%s", NULL}, 0, 0},
+    {"subject1_5", {"--batch", "%s", NULL}, 0, 1},
+    {"subject2", {"--stats-only", NULL, NULL}, 1, 0},
+    {"subject2", {"--bench-parse", "%s", NULL}, 0, 0},
+    {"subject2", {"--succinct", NULL, NULL}, 1, 0},
+    {"subject3", {"--bench-parse", "%s", NULL}, 0, 0},
+    {"subject3", {"--sparse", NULL, NULL}, 1, 0},
+};
+
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) + (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Runs one program with stdout/stderr discarded; *peakKb gets its max RSS.
+static int bench_spawn(const char *binary, const BenchRun *run, const char *input, double *seconds, long *peakKb) {
+    char *argv[5];
+    int argc = 0;
+    argv[argc++] = (char *) binary;
+    for (int i = 0; i < 3 && run->arguments[i] != NULL; i++) {
+        argv[argc++] = (char *) (strcmp(run->arguments[i], "%s") == 0 ? input : run->arguments[i]);
+    }
+    argv[argc] = NULL;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t child = fork();
+    if (child < 0) return -1;
+    if (child == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        int in = run->inputOnStdin ? open(input, O_RDONLY) : open("/dev/null", O_RDONLY);
+        if (null < 0 || in < 0) _exit(127);
+        dup2(in, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execv(binary, argv);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) < 0) return -1;
+    *seconds = seconds_since(&start);
+    *peakKb = usage.ru_maxrss;
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
+}
+
+int run_bench(const char *directory, unsigned long long targetBytes, const char *binaryDirectory) {
+    char paths[SHAPE_COUNT][2][4096];
+    unsigned long long sizes[SHAPE_COUNT][2];
+
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        printf("cannot create %s\n", directory);
+        return 1;
+    }
+    for (int shape = 0; shape < SHAPE_COUNT; shape++) {
+        for (int lines = 0; lines <= 1; lines++) {
+            snprintf(paths[shape][lines], sizeof(paths[shape][lines]), "%s/%s%s.txt", directory, shape_names[shape],
+                     lines ? "-lines" : "");
+            FILE *out = fopen(paths[shape][lines], "wb");
+            if (out == NULL) {
+                printf("file open fail: %s\n", paths[shape][lines]);
+                return 1;
+            }
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            sizes[shape][lines] = corpus_generate(out, (CorpusShape) shape, targetBytes, 1 + (uint64_t) shape, lines);
+            fclose(out);
+            fprintf(stderr, "generated %s: %llu bytes in %.2f s\n", paths[shape][lines], sizes[shape][lines],
+                    seconds_since(&start));
+        }
+    }
+
+    printf("%-11s %-14s %-10s %12s %9s %10s %10s %s\n", "program", "mode", "shape", "bytes", "seconds", "MB/s",
+           "peak MB", "status");
+    for (size_t r = 0; r < sizeof(bench_runs) / sizeof(bench_runs[0]); r++) {
+        const BenchRun *run = &bench_runs[r];
+        char binary[4096];
+        snprintf(binary, sizeof(binary), "%s/%s", binaryDirectory, run->program);
+        if (access(binary, X_OK) != 0) {
+            printf("%-11s %-14s (not built: %s)\n", run->program, run->arguments[0], binary);
+            continue;
+        }
+        for (int shape = 0; shape < SHAPE_COUNT; shape++) {
+            double seconds = 0.0;
+            long peakKb = 0;
+            int status = bench_spawn(binary, run, paths[shape][run->lines], &seconds, &peakKb);
+            double megabytes = (double) sizes[shape][run->lines] / (1024.0 * 1024.0);
+            printf("%-11s %-14s %-10s %12llu %9.3f %10.2f %10.1f %d\n", run->program, run->arguments[0],
+                   shape_names[shape], sizes[shape][run->lines], seconds, seconds > 0 ? megabytes / seconds : 0.0,
+                   (double) peakKb / 1024.0, status);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
+
+static void print_usage(void) {
+    fprintf(stderr, "usage: sexpr_corpus gen SHAPE SIZE [SEED] [--lines]\n"
+                    "       sexpr_corpus bench DIR SIZE [BINDIR]\n"
+                    "shapes: balanced skewed wide deep malformed; SIZE may end in K, M or G\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 4 && strcmp(argv[1], "gen") == 0) {
+        int shape = parse_shape(argv[2]);
+        if (shape < 0) {
+            print_usage();
+            return 1;
+        }
+        uint64_t seed = 1 + (uint64_t) shape;
+        int lines = 0;
+        for (int i = 4; i < argc; i++) {
+            if (strcmp(argv[i], "--lines") == 0) lines = 1;
+            else seed = strtoull(argv[i], NULL, 10);
+        }
+        return corpus_generate(stdout, (CorpusShape) shape, parse_size(argv[3]), seed, lines) ? 0 : 1;
+    }
+    if (argc >= 4 && strcmp(argv[1], "bench") == 0) {
+        return run_bench(argv[2], parse_size(argv[3]), argc >= 5 ? argv[4] : ".");
+    }
+    print_usage();
+    return 1;
+}
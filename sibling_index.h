@@ -0,0 +1,91 @@
+#ifndef SIBLING_INDEX_H
+#define SIBLING_INDEX_H
+
+// Prefix sums over the byte extents (gap + length) of a wide node's children,
+// kept as a Fenwick tree, for the incremental editors in hw-01.c and
+// subject2.c. Finding the child that covers an offset and growing one child
+// after an edit both take O(log fan-out) instead of a walk over the list.
+// Trees live back to back in one append-only pool, like the child lists.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Narrower nodes are walked directly; an index would not pay for itself.
+#define SIBLING_INDEX_MIN_CHILDREN 64
+#define SIBLING_INDEX_NONE UINT32_MAX
+
+typedef struct {
+    uint32_t *sums;
+    uint32_t used;
+    uint32_t capacity;
+} SiblingIndexPool;
+
+static inline void sibling_index_pool_init(SiblingIndexPool *pool) {
+    pool->sums = NULL;
+    pool->used = 0;
+    pool->capacity = 0;
+}
+
+static inline void sibling_index_pool_free(SiblingIndexPool *pool) {
+    free(pool->sums);
+    sibling_index_pool_init(pool);
+}
+
+// Reserves a tree for `count` children and returns its base; the caller
+// stores child i's extent in sums[base + i] and then calls
+// sibling_index_finish. Returns SIBLING_INDEX_NONE when out of memory.
+static inline uint32_t sibling_index_alloc(SiblingIndexPool *pool, uint32_t count) {
+    if (pool->used + count > pool->capacity) {
+        uint32_t newCapacity = pool->capacity ? pool->capacity : 1024;
+        while (newCapacity < pool->used + count) newCapacity *= 2;
+        uint32_t *grown = (uint32_t *) realloc(pool->sums, sizeof(uint32_t) * newCapacity);
+        if (grown == NULL) return SIBLING_INDEX_NONE;
+        pool->sums = grown;
+        pool->capacity = newCapacity;
+    }
+    uint32_t base = pool->used;
+    pool->used += count;
+    return base;
+}
+
+// Turns the raw extents into Fenwick sums in O(count).
+static inline void sibling_index_finish(SiblingIndexPool *pool, uint32_t base, uint32_t count) {
+    uint32_t *sums = pool->sums + base - 1; // 1-based
+    for (uint32_t i = 1; i <= count; i++) {
+        uint32_t parent = i + (i & (0u - i));
+        if (parent <= count) sums[parent] += sums[i];
+    }
+}
+
+// Child `child`'s extent changed by `delta` bytes.
+static inline void sibling_index_add(SiblingIndexPool *pool, uint32_t base, uint32_t count, uint32_t child,
+                                     long long delta) {
+    uint32_t *sums = pool->sums + base - 1;
+    for (uint32_t i = child + 1; i <= count; i += i & (0u - i)) {
+        sums[i] = (uint32_t) ((long long) sums[i] + delta);
+    }
+}
+
+// First child whose extent ends after `target` bytes from the first child's
+// extent start, or `count` when none does. *before receives the extent
+// total of the children before it.
+static inline uint32_t sibling_index_find(const SiblingIndexPool *pool, uint32_t base, uint32_t count,
+                                          size_t target, size_t *before) {
+    const uint32_t *sums = pool->sums + base - 1;
+    uint32_t position = 0;
+    size_t total = 0;
+    uint32_t step = 1;
+    while (step * 2 <= count) step *= 2;
+
+    for (; step > 0; step /= 2) {
+        if (position + step <= count && total + sums[position + step] <= target) {
+            position += step;
+            total += sums[position];
+        }
+    }
+    *before = total;
+    return position;
+}
+
+#endif
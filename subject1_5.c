@@ -1,8 +1,15 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include <stdbool.h>
 #include <string.h>
 
+#include "grow_stack.h"
+#include "line_batch.h"
+#include "sexpr_classify.h"
+
 // 파싱 결과를 담을 구조체
 typedef struct {
     // 성공 시 NULL, 에러 발생 시 해당 에러 메시지를 가리킴
@@ -11,6 +18,7 @@ typedef struct {
 
 // 에러 메시지를 상수로 정의
 const char* const ERROR_CHILD_LIMIT = "Child Limit Error: A node has more than two atom children.";
+const char* const ERROR_OUT_OF_MEMORY = "Out of Memory: The parser stack could not grow.";
 
 
 ParseResult parse_list(const char input[], int *cursor) {
@@ -57,7 +65,9 @@ bool is_valid_binary_tree_format(const char input[]) {
         cursor++;
     }
 
-    cursor++; // '('를 소모합니다.
+    if (input[cursor] != '\0') {
+        cursor++; // '('를 소모합니다. (빈 줄이면 문자열 끝을 넘어가지 않음)
+    }
 
     ParseResult result = parse_list(input, &cursor);
 
@@ -68,7 +78,409 @@ bool is_valid_binary_tree_format(const char input[]) {
     return true;
 }
 
-int main(void) {
+// ========== 명시적 스택 파서 ==========
+//
+// parse_list와 같은 판정을 재귀 없이 수행한다. 열린 리스트마다 원자 자식 수 하나를
+// 힙 스택(stack)에 쌓으므로 중첩 깊이는 메모리에만 제한된다.
+// stack은 호출자가 넘겨주며 여러 번 재사용할 수 있다.
+// 스택을 키우지 못하면 판정 대신 ERROR_OUT_OF_MEMORY를 돌려준다.
+ParseResult parse_list_iterative(const char input[], size_t *cursor, GrowStack *stack) {
+    stack->count = 0;
+    if (!grow_stack_push(stack, 0)) {
+        return (ParseResult){.error_message = ERROR_OUT_OF_MEMORY};
+    }
+
+    while (input[*cursor] != '\0') {
+        char character = input[*cursor];
+
+        if (isspace(character)) {
+            (*cursor)++;
+        } else if (character == ')') {
+            (*cursor)++;
+            if (grow_stack_pop(stack) > 2) {
+                return (ParseResult){.error_message = ERROR_CHILD_LIMIT};
+            }
+            if (grow_stack_is_empty(stack)) {
+                break; // 최상위 리스트가 닫힘: 나머지 입력은 재귀 버전처럼 무시
+            }
+        } else if (character == '(') {
+            (*cursor)++;
+            if (!grow_stack_push(stack, 0)) {
+                return (ParseResult){.error_message = ERROR_OUT_OF_MEMORY};
+            }
+        } else {
+            (*grow_stack_peek(stack, 0))++;
+            (*cursor)++;
+        }
+    }
+
+    // 닫히지 않은 리스트는 재귀 버전과 마찬가지로 검사하지 않음
+    return (ParseResult){.error_message = NULL};
+}
+
+// is_valid_binary_tree_format과 같은 판정을 ParseResult로 돌려준다 (메모리 부족과 FALSE를 구별)
+ParseResult check_binary_tree_format_iterative(const char input[], GrowStack *stack) {
+    size_t cursor = 0;
+
+    while (isspace(input[cursor])) {
+        cursor++;
+    }
+
+    if (input[cursor] != '\0') {
+        cursor++;
+    }
+
+    return parse_list_iterative(input, &cursor, stack);
+}
+
+// 판정 결과를 출력할 문자열
+static const char *verdict_name(ParseResult result) {
+    if (result.error_message == NULL) return "TRUE";
+    return result.error_message == ERROR_OUT_OF_MEMORY ? "ERROR" : "FALSE";
+}
+
+// 재귀 파서와 명시적 스택 파서의 시간 비교 (깊이가 너무 깊으면 재귀 버전은 생략)
+int run_parse_bench_mode(const char *path) {
+    size_t size = 0;
+    char *input = line_batch_load_file(path, &size);
+    if (input == NULL) return 1;
+    long long maxDepth = sexpr_max_depth(input, size);
+    struct timespec start, finish;
+    double seconds;
+
+    printf("input: %zu bytes, max depth %lld\n", size, maxDepth);
+    if (maxDepth <= RECURSIVE_BENCH_DEPTH_LIMIT) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool recursiveResult = is_valid_binary_tree_format(input);
+        clock_gettime(CLOCK_MONOTONIC, &finish);
+        seconds = (double) (finish.tv_sec - start.tv_sec) + (double) (finish.tv_nsec - start.tv_nsec) / 1e9;
+        printf("recursive: %s, %.3f s, %.2f MB/s\n", recursiveResult ? "TRUE" : "FALSE", seconds,
+               seconds > 0 ? (double) size / (1024.0 * 1024.0) / seconds : 0.0);
+    } else {
+        printf("recursive: skipped (depth > %d)\n", RECURSIVE_BENCH_DEPTH_LIMIT);
+    }
+
+    GrowStack stack;
+    grow_stack_init(&stack);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ParseResult iterativeResult = check_binary_tree_format_iterative(input, &stack);
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    seconds = (double) (finish.tv_sec - start.tv_sec) + (double) (finish.tv_nsec - start.tv_nsec) / 1e9;
+    printf("iterative: %s, %.3f s, %.2f MB/s\n", verdict_name(iterativeResult), seconds,
+           seconds > 0 ? (double) size / (1024.0 * 1024.0) / seconds : 0.0);
+
+    grow_stack_free(&stack);
+    free(input);
+    return 0;
+}
+
+// ========== 병렬 검증 (하나의 거대한 식) ==========
+//
+// parse_list는 문자 단위 재귀라서 한 코어만 쓰고 깊게 중첩되면 스택이 터진다.
+// 아래 검증기는 같은 판정을 재귀 없이 네 단계로 나누어 수행한다.
+//   1) 청크별 괄호 순증가량(net)과 최소 깊이(min)를 병렬로 계산
+//   2) 순차 prefix scan으로 각 청크의 시작 깊이를 구하고,
+//      최상위 리스트가 닫히는(깊이 0이 되는) 청크까지만 남김
+//   3) 청크 안에서 열리고 닫히는 리스트의 원자 자식 수를 병렬로 검사
+//   4) 청크 경계를 넘는 리스트의 부분 개수를 순서대로 합쳐서 검사
+// 원자 자식 수는 2보다 큰지만 알면 되므로 3에서 포화시켜 1바이트로 저장한다.
+
+#ifndef PARALLEL_MIN_CHUNK
+#define PARALLEL_MIN_CHUNK (1 << 20)
+#endif
+
+typedef struct {
+    unsigned char *items;
+    size_t count;
+    size_t capacity;
+} CountStack;
+
+typedef struct {
+    const char *start;
+    const char *end;
+    long long net;              // 청크 끝의 상대 깊이
+    long long min;              // 청크 안의 최소 상대 깊이 (<= 0)
+    long long startDepth;       // 청크 시작 시점의 절대 깊이 (2단계에서 채움)
+    bool error;                 // 청크 내부에서 완결된 리스트의 자식 수 초과
+    bool outOfMemory;           // 스택을 키우지 못해 검사를 중단함 (판정 불가)
+    bool closesTopLevel;        // 최상위 리스트가 이 청크에서 닫힘
+    CountStack closedBefore;    // 청크 이전에 열려 이 청크에서 닫힌 리스트들의 부분 개수
+    unsigned char carried;      // 최소 깊이에 있는(계속 열려 있는) 기존 리스트의 부분 개수
+    CountStack openAtEnd;       // 청크에서 새로 열려 끝까지 닫히지 않은 리스트들
+} DepthChunk;
+
+typedef struct {
+    DepthChunk *chunks;
+    size_t chunkCount;
+    size_t nextChunk;
+    int phase;
+} ParallelJob;
+
+static bool count_stack_push(CountStack *stack, unsigned char value) {
+    if (stack->count == stack->capacity) {
+        size_t newCapacity = stack->capacity ? stack->capacity * 2 : 64;
+        unsigned char *grown = (unsigned char *) realloc(stack->items, newCapacity);
+        if (grown == NULL) return false;
+        stack->items = grown;
+        stack->capacity = newCapacity;
+    }
+    stack->items[stack->count++] = value;
+    return true;
+}
+
+static unsigned char saturating_add(unsigned char count, unsigned char amount) {
+    unsigned int sum = (unsigned int) count + amount;
+    return (unsigned char) (sum > 3 ? 3 : sum);
+}
+
+static void chunk_depth_summary(DepthChunk *chunk) {
+    long long depth = 0;
+    long long min = 0;
+
+    for (const char *p = chunk->start; p < chunk->end; p++) {
+        if (*p == '(') {
+            depth++;
+        } else if (*p == ')') {
+            depth--;
+            if (depth < min) min = depth;
+        }
+    }
+    chunk->net = depth;
+    chunk->min = min;
+}
+
+static void chunk_child_limit(DepthChunk *chunk) {
+    CountStack local = {NULL, 0, 0};
+    long long depth = 0;
+    long long low = 0;
+    unsigned char pending = 0;
+
+    for (const char *p = chunk->start; p < chunk->end; p++) {
+        unsigned char character = (unsigned char) *p;
+
+        if (character == '(') {
+            depth++;
+            // 실패한 채 계속 가면 짝이 되는 ')'에서 빈 스택을 꺼내므로 청크를 멈춘다
+            if (!count_stack_push(&local, 0)) {
+                chunk->outOfMemory = true;
+                break;
+            }
+        } else if (character == ')') {
+            if (depth == low) {
+                // 청크 이전에 열린 리스트가 닫힘: 부분 개수만 남겨 4단계에서 합산
+                if (!count_stack_push(&chunk->closedBefore, pending)) {
+                    chunk->outOfMemory = true;
+                    break;
+                }
+                pending = 0;
+                low--;
+                depth--;
+                if (chunk->startDepth + depth == 0) {
+                    chunk->closesTopLevel = true;
+                    break;
+                }
+            } else {
+                if (local.items[--local.count] > 2) chunk->error = true;
+                depth--;
+            }
+        } else if (!isspace(character)) {
+            if (depth == low) {
+                pending = saturating_add(pending, 1);
+            } else {
+                local.items[local.count - 1] = saturating_add(local.items[local.count - 1], 1);
+            }
+        }
+    }
+    chunk->carried = pending;
+    chunk->openAtEnd = local;
+}
+
+static void *parallel_worker(void *argument) {
+    ParallelJob *job = (ParallelJob *) argument;
+
+    for (;;) {
+        size_t index = __atomic_fetch_add(&job->nextChunk, 1, __ATOMIC_RELAXED);
+        if (index >= job->chunkCount) break;
+        if (job->phase == 1) {
+            chunk_depth_summary(&job->chunks[index]);
+        } else {
+            chunk_child_limit(&job->chunks[index]);
+        }
+    }
+    return NULL;
+}
+
+// 스레드 배열을 할당하지 못하면 false.
+// 청크는 공유 카운터로 나눠 가지므로 생성된 스레드만으로도 모든 청크를 처리하며,
+// 하나도 생성되지 않으면 호출한 스레드가 직접 처리한다.
+static bool run_parallel_phase(ParallelJob *job, int phase, int threadCount) {
+    pthread_t *threads = (pthread_t *) malloc(sizeof(pthread_t) * (size_t) threadCount);
+    if (threads == NULL) return false;
+
+    job->phase = phase;
+    job->nextChunk = 0;
+    int started = 0;
+    for (int i = 0; i < threadCount; i++) {
+        if (pthread_create(&threads[started], NULL, parallel_worker, job) == 0) started++;
+    }
+    if (started == 0) parallel_worker(job);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    return true;
+}
+
+ParseResult parallel_validate(const char input[], size_t length, int threadCount) {
+    ParseResult result = {.error_message = NULL};
+    size_t cursor = 0;
+
+    // is_valid_binary_tree_format과 같이 공백 뒤 첫 글자를 '('로 보고 소모
+    while (cursor < length && isspace((unsigned char) input[cursor])) {
+        cursor++;
+    }
+    if (cursor < length) cursor++;
+    if (cursor >= length) return result;
+
+    size_t remaining = length - cursor;
+    size_t chunkCount = (size_t) threadCount * 4;
+    if (remaining / chunkCount < PARALLEL_MIN_CHUNK) {
+        chunkCount = remaining / PARALLEL_MIN_CHUNK + 1;
+    }
+    size_t chunkSize = (remaining + chunkCount - 1) / chunkCount;
+
+    DepthChunk *chunks = (DepthChunk *) calloc(chunkCount, sizeof(DepthChunk));
+    if (chunks == NULL) return (ParseResult){.error_message = ERROR_OUT_OF_MEMORY};
+    for (size_t i = 0; i < chunkCount; i++) {
+        size_t begin = cursor + i * chunkSize;
+        size_t finish = begin + chunkSize;
+        if (begin > length) begin = length;
+        if (finish > length) finish = length;
+        chunks[i].start = input + begin;
+        chunks[i].end = input + finish;
+    }
+
+    // 1단계: 청크별 깊이 요약
+    ParallelJob job = {chunks, chunkCount, 0, 0};
+    if (!run_parallel_phase(&job, 1, threadCount)) {
+        free(chunks);
+        return (ParseResult){.error_message = ERROR_OUT_OF_MEMORY};
+    }
+
+    // 2단계: prefix scan. 최상위 리스트(절대 깊이 1)가 닫히는 청크 이후는 무시
+    long long depth = 1;
+    size_t usedChunks = chunkCount;
+    for (size_t i = 0; i < chunkCount; i++) {
+        chunks[i].startDepth = depth;
+        if (depth + chunks[i].min <= 0) {
+            usedChunks = i + 1;
+            break;
+        }
+        depth += chunks[i].net;
+    }
+
+    // 3단계: 청크별 원자 자식 수 검사
+    job.chunkCount = usedChunks;
+    if (!run_parallel_phase(&job, 3, threadCount)) {
+        result.error_message = ERROR_OUT_OF_MEMORY;
+    }
+
+    // 4단계: 청크 경계를 넘는 리스트 합산 (스택 바닥은 최상위 리스트)
+    // 중단된 청크가 있으면 부분 개수가 빠져 있으므로 판정하지 않는다
+    CountStack open = {NULL, 0, 0};
+    for (size_t i = 0; i < usedChunks && result.error_message == NULL; i++) {
+        if (chunks[i].outOfMemory) result.error_message = ERROR_OUT_OF_MEMORY;
+    }
+    if (result.error_message == NULL && !count_stack_push(&open, 0)) {
+        result.error_message = ERROR_OUT_OF_MEMORY;
+    }
+    for (size_t i = 0; i < usedChunks && result.error_message == NULL; i++) {
+        DepthChunk *chunk = &chunks[i];
+        if (chunk->error) {
+            result.error_message = ERROR_CHILD_LIMIT;
+            break;
+        }
+        for (size_t k = 0; k < chunk->closedBefore.count; k++) {
+            unsigned char total = saturating_add(open.items[open.count - 1], chunk->closedBefore.items[k]);
+            open.count--;
+            if (total > 2) {
+                result.error_message = ERROR_CHILD_LIMIT;
+                break;
+            }
+        }
+        if (result.error_message != NULL || chunk->closesTopLevel) break;
+
+        open.items[open.count - 1] = saturating_add(open.items[open.count - 1], chunk->carried);
+        for (size_t k = 0; k < chunk->openAtEnd.count; k++) {
+            if (!count_stack_push(&open, chunk->openAtEnd.items[k])) {
+                result.error_message = ERROR_OUT_OF_MEMORY;
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < chunkCount; i++) {
+        free(chunks[i].closedBefore.items);
+        free(chunks[i].openAtEnd.items);
+    }
+    free(open.items);
+    free(chunks);
+    return result;
+}
+
+int run_parallel_mode(const char *path, int threadCount) {
+    size_t size = 0;
+    char *input = line_batch_load_file(path, &size);
+    if (input == NULL) return 1;
+    if (threadCount < 1) threadCount = line_batch_default_threads();
+
+    struct timespec start, finish;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ParseResult result = parallel_validate(input, size, threadCount);
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    double seconds = (double) (finish.tv_sec - start.tv_sec) + (double) (finish.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%s", verdict_name(result));
+    fprintf(stderr, "\nparallel: %zu bytes, %d threads, %.3f s, %.2f MB/s\n", size, threadCount, seconds,
+            seconds > 0 ? (double) size / (1024.0 * 1024.0) / seconds : 0.0);
+
+    free(input);
+    return result.error_message == ERROR_OUT_OF_MEMORY ? 1 : 0;
+}
+
+// 배치 모드: 한 줄에 하나씩 들어 있는 식을 스레드 풀로 나누어 검사
+// (판정은 TRUE/FALSE 두 가지이고, ERROR는 스택을 키울 메모리가 없을 때만 나온다)
+// 스레드마다 스택 하나를 만들어 모든 줄에 재사용
+static void *batch_create_stack(void) {
+    GrowStack *stack = (GrowStack *) malloc(sizeof(GrowStack));
+    if (stack != NULL) grow_stack_init(stack);
+    return stack;
+}
+
+static void batch_destroy_stack(void *scratch) {
+    grow_stack_free((GrowStack *) scratch);
+    free(scratch);
+}
+
+static int batch_validate_line(char line[], size_t length, void *scratch) {
+    (void) length;
+    ParseResult result = check_binary_tree_format_iterative(line, (GrowStack *) scratch);
+    if (result.error_message == NULL) return BATCH_TRUE;
+    return result.error_message == ERROR_OUT_OF_MEMORY ? BATCH_ERROR : BATCH_FALSE;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "--batch") == 0) {
+        LineBatchValidator validator = {batch_create_stack, batch_destroy_stack, batch_validate_line};
+        return run_line_batch(argv[2], argc >= 4 ? atoi(argv[3]) : 0, &validator, stdout);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--bench-parse") == 0) {
+        return run_parse_bench_mode(argv[2]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--parallel") == 0) {
+        return run_parallel_mode(argv[2], argc >= 4 ? atoi(argv[3]) : 0);
+    }
+
     char buffer[256];
 
     if (fgets(buffer, sizeof(buffer), stdin) == NULL) {
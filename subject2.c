@@ -1,154 +1,2188 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "bp_tree.h"
+#include "grow_stack.h"
+#include "sexpr_classify.h"
+#include "sibling_index.h"
 
 #define MAX_NODES 200
-#define MAX_LEN   1000
+#define NO_NODE   UINT32_MAX
+#define NO_SYMBOL UINT32_MAX
 
-typedef struct Node {
-    char value[10];
-    struct Node **children;
-    int childCount;
+// 라벨 인터너: 라벨 바이트열 -> 32비트 심볼 번호 (열린 주소 해시, 선형 탐사).
+// 서로 다른 라벨만 bytes에 NUL로 끝맺어 한 번씩 모아 두므로 같은 라벨이 많을수록 메모리가 줄고,
+// 라벨 비교는 번호 비교가 된다.
+typedef struct {
+    char *bytes;
+    uint32_t bytesUsed;
+    uint32_t bytesCapacity;
+    uint32_t *offsets;      // 심볼 번호 -> bytes 안의 시작 위치
+    uint32_t count;
+    uint32_t offsetCapacity;
+    uint32_t *slots;        // 심볼 번호 + 1 (0 = 빈 칸)
+    uint32_t slotCapacity;
+} SymbolTable;
+
+// 노드는 아레나의 큰 배열 몇 개에 32비트 인덱스로 저장한다.
+// 각 노드의 자식 인덱스는 children 배열에 연속 구간(firstChild부터 childCount개)으로 놓인다.
+typedef struct {
+    uint32_t label;         // arena->symbols의 심볼 번호
+    uint32_t firstChild;
+    uint32_t childCount;
 } Node;
 
-char *tree_array[MAX_NODES];
+typedef struct {
+    SymbolTable symbols;
+    Node *nodes;
+    uint32_t nodeCount;
+    uint32_t nodeCapacity;
+    uint32_t *children;
+    uint32_t childCount;
+    uint32_t childCapacity;
+    // 파싱 중 아직 부모에 붙지 않은 자식 인덱스 (부모가 끝나면 children으로 한 번에 복사)
+    uint32_t *pending;
+    uint32_t pendingCount;
+    uint32_t pendingCapacity;
+    // 해시 콘싱 모드: (라벨, 자식 번호들)이 같은 서브트리는 노드 하나를 공유한다 (트리 -> DAG).
+    // 공유 노드는 트리 기준으로 여러 번 세어야 하므로 노드별 통계를 만들 때 함께 기록한다.
+    int hashConsing;
+    uint32_t *consTable;    // 노드 번호 + 1 (0 = 빈 칸), 선형 탐사
+    uint32_t consCapacity;
+    uint32_t consCount;
+    uint32_t *memoNodes;    // memo가 NULL이 아니면 tree_height/total_nodes/leaf_nodes가 바로 사용
+    uint32_t *memoLeaves;
+    int *memoHeight;
+    uint32_t memoCapacity;
+    uint32_t sharedHits;    // 기존 노드를 재사용한 횟수
+    // recordSpans이면 parse_iterative가 노드마다 소스 구간 [spanStart, spanEnd)를 기록한다 (증분 파싱용)
+    int recordSpans;
+    uint32_t *spanStart;
+    uint32_t *spanEnd;
+    uint32_t spanStartCapacity;
+    uint32_t spanEndCapacity;
+    const uint32_t *reuseNodes;     // TOKEN_NODE 토큰이 가리키는 기존 노드 (spanStart/spanEnd는 호출자가 채움)
+    int outOfMemory;        // 파싱 중 메모리가 부족했으면 1 (이때 파서는 NO_NODE를 돌려주고 트리는 쓸 수 없다)
+} NodeArena;
+
+SymbolTable tree_symbols;          // tree_array의 심볼 표 (made_tree의 아레나가 빌려 쓰고 main이 해제)
+uint32_t tree_array[MAX_NODES];    // 힙 번호 -> tree_symbols의 심볼 번호 (빈 칸은 NO_SYMBOL)
 
-char *tokens[MAX_LEN];
+// 토큰은 입력 버퍼를 가리키는 (종류, 위치, 길이) 레코드로만 저장 (토큰별 할당 없음)
+typedef enum {
+    TOKEN_OPEN,
+    TOKEN_CLOSE,
+    TOKEN_LABEL,
+    TOKEN_NODE      // 증분 파싱 전용: 바뀌지 않은 기존 서브트리 하나 (length = reuseNodes 번호)
+} TokenKind;
+
+typedef struct {
+    TokenKind kind;
+    int offset;
+    int length;
+} Token;
+
+const char *source = NULL;
+Token *tokens = NULL;
 int tokenCount = 0;
+int tokenCapacity = 0;
 int pos = 0;
 
-int tree_height(Node *node) {
-    if (!node) return -1;
-    if (node->childCount == 0) return 0;
+// 토큰의 위치/길이와 토큰 번호가 int이므로 이보다 긴 입력은 토큰화하지 않는다
+#define MAX_SOURCE_LENGTH ((size_t)INT_MAX)
+
+static int grow_array(void **array, uint32_t *capacity, uint32_t needed, size_t elementSize) {
+    if (needed <= *capacity) return 1;
+    uint32_t newCapacity = *capacity ? *capacity : 1024;
+    while (newCapacity < needed) newCapacity *= 2;
+    void *grown = realloc(*array, elementSize * newCapacity);
+    if (!grown) return 0;
+    *array = grown;
+    *capacity = newCapacity;
+    return 1;
+}
+
+static uint32_t symbol_hash(const char *label, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) hash = (hash ^ (unsigned char)label[i]) * 16777619u;
+    return hash * 0x9E3779B1u;
+}
+
+static int symbol_grow_slots(SymbolTable *table) {
+    uint32_t newCapacity = table->slotCapacity ? table->slotCapacity * 2 : 1024;
+    uint32_t *slots = (uint32_t*)calloc(newCapacity, sizeof(uint32_t));
+    if (!slots) return 0;
+    for (uint32_t i = 0; i < table->slotCapacity; i++) {
+        uint32_t entry = table->slots[i];
+        if (!entry) continue;
+        const char *name = table->bytes + table->offsets[entry - 1];
+        uint32_t slot = symbol_hash(name, (int)strlen(name)) & (newCapacity - 1);
+        while (slots[slot]) slot = (slot + 1) & (newCapacity - 1);
+        slots[slot] = entry;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->slotCapacity = newCapacity;
+    return 1;
+}
+
+// label[0, length)의 심볼 번호 (처음 보는 라벨이면 새로 등록). 메모리가 부족하면 NO_SYMBOL
+static uint32_t symbol_intern(SymbolTable *table, const char *label, int length) {
+    if ((table->count + 1) * 2 > table->slotCapacity && !symbol_grow_slots(table)) return NO_SYMBOL;
+    uint32_t slot = symbol_hash(label, length) & (table->slotCapacity - 1);
+    while (table->slots[slot]) {
+        uint32_t symbol = table->slots[slot] - 1;
+        const char *name = table->bytes + table->offsets[symbol];
+        if (memcmp(name, label, length) == 0 && name[length] == '\0') return symbol;
+        slot = (slot + 1) & (table->slotCapacity - 1);
+    }
+
+    if (!grow_array((void**)&table->bytes, &table->bytesCapacity, table->bytesUsed + (uint32_t)length + 1, 1) ||
+        !grow_array((void**)&table->offsets, &table->offsetCapacity, table->count + 1, sizeof(uint32_t)))
+        return NO_SYMBOL;
+    memcpy(table->bytes + table->bytesUsed, label, length);
+    table->bytes[table->bytesUsed + length] = '\0';
+    table->offsets[table->count] = table->bytesUsed;
+    table->bytesUsed += (uint32_t)length + 1;
+    table->slots[slot] = table->count + 1;
+    return table->count++;
+}
+
+static inline const char *symbol_name(const SymbolTable *table, uint32_t symbol) {
+    return table->bytes + table->offsets[symbol];
+}
+
+static size_t symbol_table_bytes(const SymbolTable *table) {
+    return table->bytesUsed + sizeof(uint32_t) * ((size_t)table->count + table->slotCapacity);
+}
+
+static void symbol_table_free(SymbolTable *table) {
+    free(table->bytes);
+    free(table->offsets);
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
+
+void arena_init(NodeArena *arena) {
+    memset(arena, 0, sizeof(*arena));
+}
+
+// 트리 전체를 O(1)에 해제 (노드 개수와 무관하게 블록 몇 개)
+void arena_free(NodeArena *arena) {
+    free(arena->nodes);
+    free(arena->children);
+    free(arena->pending);
+    free(arena->consTable);
+    free(arena->memoNodes);
+    free(arena->memoLeaves);
+    free(arena->memoHeight);
+    free(arena->spanStart);
+    free(arena->spanEnd);
+    symbol_table_free(&arena->symbols);
+    arena_init(arena);
+}
+
+static uint32_t arena_new_node(NodeArena *arena, const char *label, int length) {
+    if (!grow_array((void**)&arena->nodes, &arena->nodeCapacity, arena->nodeCount + 1, sizeof(Node)))
+        return NO_NODE;
+    uint32_t symbol = symbol_intern(&arena->symbols, label, length);
+    if (symbol == NO_SYMBOL) return NO_NODE;
+    Node *node = &arena->nodes[arena->nodeCount];
+    node->label = symbol;
+    node->firstChild = 0;
+    node->childCount = 0;
+    return arena->nodeCount++;
+}
+
+// 메모리가 부족하면 0
+static int arena_push_pending(NodeArena *arena, uint32_t child) {
+    if (!grow_array((void**)&arena->pending, &arena->pendingCapacity, arena->pendingCount + 1, sizeof(uint32_t)))
+        return 0;
+    arena->pending[arena->pendingCount++] = child;
+    return 1;
+}
+
+// pending[mark..] 를 node의 자식 구간으로 확정. 메모리가 부족하면 0
+static int arena_attach_pending(NodeArena *arena, uint32_t node, uint32_t mark) {
+    uint32_t count = arena->pendingCount - mark;
+    if (!grow_array((void**)&arena->children, &arena->childCapacity, arena->childCount + count, sizeof(uint32_t)))
+        return 0;
+    memcpy(arena->children + arena->childCount, arena->pending + mark, sizeof(uint32_t) * count);
+    arena->nodes[node].firstChild = arena->childCount;
+    arena->nodes[node].childCount = count;
+    arena->childCount += count;
+    arena->pendingCount = mark;
+    return 1;
+}
+
+static void arena_record_span(NodeArena *arena, uint32_t node, int start, int end) {
+    if (!grow_array((void**)&arena->spanStart, &arena->spanStartCapacity, node + 1, sizeof(uint32_t)) ||
+        !grow_array((void**)&arena->spanEnd, &arena->spanEndCapacity, node + 1, sizeof(uint32_t)))
+        return;
+    if (start >= 0) arena->spanStart[node] = (uint32_t)start;
+    if (end >= 0) arena->spanEnd[node] = (uint32_t)end;
+}
+
+static inline uint32_t child_at(const NodeArena *arena, uint32_t node, uint32_t i) {
+    return arena->children[arena->nodes[node].firstChild + i];
+}
+
+static uint32_t cons_hash(uint32_t label, const uint32_t *children, uint32_t count) {
+    uint32_t hash = (2166136261u ^ label) * 16777619u;
+    for (uint32_t i = 0; i < count; i++) hash = (hash ^ children[i]) * 16777619u ^ (hash >> 15);
+    return hash * 0x9E3779B1u;
+}
+
+static int cons_grow(NodeArena *arena) {
+    uint32_t newCapacity = arena->consCapacity ? arena->consCapacity * 2 : 1024;
+    uint32_t *table = (uint32_t*)calloc(newCapacity, sizeof(uint32_t));
+    if (!table) return 0;
+    for (uint32_t i = 0; i < arena->consCapacity; i++) {
+        uint32_t entry = arena->consTable[i];
+        if (!entry) continue;
+        const Node *node = &arena->nodes[entry - 1];
+        uint32_t slot = cons_hash(node->label, arena->children + node->firstChild, node->childCount) & (newCapacity - 1);
+        while (table[slot]) slot = (slot + 1) & (newCapacity - 1);
+        table[slot] = entry;
+    }
+    free(arena->consTable);
+    arena->consTable = table;
+    arena->consCapacity = newCapacity;
+    return 1;
+}
+
+// 노드별 통계 배열 확보. 실패하면 통계를 버려 재귀 계산(공유 노드를 다시 방문)으로 돌아간다.
+static int memo_reserve(NodeArena *arena, uint32_t needed) {
+    if (!arena->memoNodes && arena->memoCapacity) return 0;   // 이전에 실패함
+    if (needed <= arena->memoCapacity) return 1;
+    uint32_t newCapacity = arena->memoCapacity ? arena->memoCapacity : 1024;
+    while (newCapacity < needed) newCapacity *= 2;
+
+    uint32_t *nodes = (uint32_t*)realloc(arena->memoNodes, sizeof(uint32_t) * newCapacity);
+    if (nodes) arena->memoNodes = nodes;
+    uint32_t *leaves = nodes ? (uint32_t*)realloc(arena->memoLeaves, sizeof(uint32_t) * newCapacity) : NULL;
+    if (leaves) arena->memoLeaves = leaves;
+    int *height = leaves ? (int*)realloc(arena->memoHeight, sizeof(int) * newCapacity) : NULL;
+    if (height) arena->memoHeight = height;
+    if (!height) {
+        free(arena->memoNodes);
+        free(arena->memoLeaves);
+        free(arena->memoHeight);
+        arena->memoNodes = arena->memoLeaves = NULL;
+        arena->memoHeight = NULL;
+        arena->memoCapacity = 1;
+        return 0;
+    }
+    arena->memoCapacity = newCapacity;
+    return 1;
+}
+
+// 해시 콘싱 모드에서 arena_attach_pending 대신 호출: pending[mark..]를 자식으로 갖는 node가
+// 이미 있으면 node를 되돌리고 기존 노드를 돌려준다. node의 자식이 모두 기존 노드와 같다는 것은
+// 자식들도 전부 되돌려졌다는 뜻이므로, node는 항상 아레나의 마지막 노드다.
+// 자식 구간을 만들 메모리가 없으면 NO_NODE.
+static uint32_t arena_intern_pending(NodeArena *arena, uint32_t node, uint32_t mark) {
+    uint32_t count = arena->pendingCount - mark;
+    const uint32_t *children = arena->pending + mark;
+    uint32_t label = arena->nodes[node].label;
+
+    int canInsert = (arena->consCount + 1) * 2 <= arena->consCapacity || cons_grow(arena);
+    uint32_t slot = canInsert ? cons_hash(label, children, count) & (arena->consCapacity - 1) : 0;
+    while (canInsert && arena->consTable[slot]) {
+        uint32_t candidate = arena->consTable[slot] - 1;
+        const Node *existing = &arena->nodes[candidate];
+        if (existing->childCount == count && existing->label == label &&
+            memcmp(arena->children + existing->firstChild, children, sizeof(uint32_t) * count) == 0) {
+            arena->pendingCount = mark;
+            if (node == arena->nodeCount - 1) arena->nodeCount--;
+            arena->sharedHits++;
+            return candidate;
+        }
+        slot = (slot + 1) & (arena->consCapacity - 1);
+    }
+
+    if (!arena_attach_pending(arena, node, mark)) return NO_NODE;
+    if (canInsert) {
+        arena->consTable[slot] = node + 1;
+        arena->consCount++;
+    }
+    if (!memo_reserve(arena, node + 1)) return node;
+
+    uint32_t nodes = 1, leaves = count == 0 ? 1 : 0;
+    int height = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t child = child_at(arena, node, i);
+        nodes += arena->memoNodes[child];
+        leaves += arena->memoLeaves[child];
+        if (arena->memoHeight[child] + 1 > height) height = arena->memoHeight[child] + 1;
+    }
+    arena->memoNodes[node] = nodes;
+    arena->memoLeaves[node] = leaves;
+    arena->memoHeight[node] = height;
+    return node;
+}
+
+// 해시 콘싱으로 만든 DAG면 노드별로 기록해 둔 트리 기준 값을 그대로 돌려준다
+int tree_height(const NodeArena *arena, uint32_t node) {
+    if (node == NO_NODE) return -1;
+    if (arena->memoHeight) return arena->memoHeight[node];
+    if (arena->nodes[node].childCount == 0) return 0;
 
     int maxChildHeight = 0;
-    for (int i = 0; i < node->childCount; i++) {
-        int h = tree_height(node->children[i]);
+    for (uint32_t i = 0; i < arena->nodes[node].childCount; i++) {
+        int h = tree_height(arena, child_at(arena, node, i));
         if (h > maxChildHeight) maxChildHeight = h;
     }
     return maxChildHeight + 1;
 }
 
-int total_nodes(Node *node) {
-    if (!node) return 0;
+int total_nodes(const NodeArena *arena, uint32_t node) {
+    if (node == NO_NODE) return 0;
+    if (arena->memoNodes) return (int)arena->memoNodes[node];
     int count = 1;
-    for (int i = 0; i < node->childCount; i++)
-        count += total_nodes(node->children[i]);
+    for (uint32_t i = 0; i < arena->nodes[node].childCount; i++)
+        count += total_nodes(arena, child_at(arena, node, i));
     return count;
 }
 
-int leaf_nodes(Node *node) {
-    if (!node) return 0;
-    if (node->childCount == 0) return 1;
+int leaf_nodes(const NodeArena *arena, uint32_t node) {
+    if (node == NO_NODE) return 0;
+    if (arena->memoLeaves) return (int)arena->memoLeaves[node];
+    if (arena->nodes[node].childCount == 0) return 1;
 
     int count = 0;
-    for (int i = 0; i < node->childCount; i++)
-        count += leaf_nodes(node->children[i]);
+    for (uint32_t i = 0; i < arena->nodes[node].childCount; i++)
+        count += leaf_nodes(arena, child_at(arena, node, i));
     return count;
 }
 
-void scanExpression(const char *expr) {
-    tokenCount = 0;
-    const char *p = expr;
-    while (*p) {
-        if (*p == '(' || *p == ')') {
-            char *tok = (char*)malloc(2);
-            tok[0] = *p; tok[1] = '\0';
-            tokens[tokenCount++] = tok;
-            p++;
-        } else if (isspace(*p)) {
-            p++;
-        } else if (isalpha(*p)) {
-            char *tok = (char*)malloc(2);
-            tok[0] = *p; tok[1] = '\0';
-            tokens[tokenCount++] = tok;
-            p++;
-        } else {
-            p++;
-        }
+// 토큰 배열을 키우지 못하면 0
+static int push_token(TokenKind kind, int offset, int length) {
+    if (tokenCount == tokenCapacity) {
+        if (tokenCapacity == INT_MAX) return 0;
+        int newCapacity = tokenCapacity == 0 ? 1024 : tokenCapacity > INT_MAX / 2 ? INT_MAX : tokenCapacity * 2;
+        Token *grown = (Token*)realloc(tokens, sizeof(Token) * newCapacity);
+        if (!grown) return 0;
+        tokens = grown;
+        tokenCapacity = newCapacity;
     }
+    tokens[tokenCount].kind = kind;
+    tokens[tokenCount].offset = offset;
+    tokens[tokenCount].length = length;
+    tokenCount++;
+    return 1;
+}
+
+// 연속된 라벨 글자는 라벨 하나다: 라벨이 시작하는 위치만 남긴다.
+// carry = 앞 블록의 마지막 바이트가 라벨 글자였는지 (라벨은 블록 경계를 넘을 수 있다)
+static inline uint64_t label_starts(uint64_t label, uint64_t carry) {
+    return label & ~((label << 1) | carry);
+}
+
+// bit에서 시작하는 라벨 글자 연속 길이 (블록 끝까지)
+static inline int label_run(uint64_t label, int bit) {
+    uint64_t rest = ~(label >> bit);
+    return rest ? __builtin_ctzll(rest) : SEXPR_BLOCK - bit;
 }
 
-void free_tokens() {
-    for (int i = 0; i < tokenCount; i++) {
-        free(tokens[i]);
-        tokens[i] = NULL;
+// source[begin, end)의 토큰을 이어 붙인다 (위치는 source 기준).
+// 메모리가 부족하거나 end가 MAX_SOURCE_LENGTH를 넘으면 0
+static int scan_range(size_t begin, size_t end) {
+    if (end > MAX_SOURCE_LENGTH) return 0;
+    uint64_t carry = 0;
+    // 64바이트씩 분류해서 괄호/라벨 시작 위치만 방문 (공백과 기타 문자는 건너뜀)
+    for (size_t base = begin; base < end; base += SEXPR_BLOCK) {
+        size_t blockLength = end - base < SEXPR_BLOCK ? end - base : SEXPR_BLOCK;
+        SexprMasks masks;
+        sexpr_classify_simd(source + base, blockLength, &masks);
+
+        if (carry && (masks.label & 1)) tokens[tokenCount - 1].length += label_run(masks.label, 0);
+        uint64_t starts = label_starts(masks.label, carry);
+        uint64_t structural = masks.open | masks.close | starts;
+        while (structural != 0) {
+            int bit = __builtin_ctzll(structural);
+            uint64_t mask = (uint64_t)1 << bit;
+            structural &= structural - 1;
+
+            int pushed;
+            if (starts & mask) pushed = push_token(TOKEN_LABEL, (int)(base + bit), label_run(masks.label, bit));
+            else pushed = push_token((masks.open & mask) ? TOKEN_OPEN : TOKEN_CLOSE, (int)(base + bit), 1);
+            if (!pushed) return 0;
+        }
+        carry = masks.label >> 63;
     }
+    return 1;
+}
+
+// 토큰 배열을 만들지 못하거나 입력이 MAX_SOURCE_LENGTH보다 길면 0 (이때 tokens는 일부만 채워져 있다)
+int scanExpression(const char *expr) {
     tokenCount = 0;
+    source = expr;
+    return scan_range(0, strlen(expr));
 }
 
-Node* parse() {
-    if (pos >= tokenCount) return NULL;
+uint32_t parse(NodeArena *arena) {
+    if (pos >= tokenCount) return NO_NODE;
 
-    char *tok = tokens[pos++];
+    Token tok = tokens[pos++];
 
-    if (strcmp(tok, "(") == 0) {
-        Node *root = parse();
+    if (tok.kind == TOKEN_OPEN) {
+        uint32_t root = parse(arena);
         return root;
-    } else if (strcmp(tok, ")") == 0) {
-        return NULL;
+    } else if (tok.kind == TOKEN_CLOSE) {
+        return NO_NODE;
     } else {
-        Node *node = (Node*)malloc(sizeof(Node));
-        strcpy(node->value, tok);
-        node->children = (Node**)malloc(sizeof(Node*) * MAX_NODES);
-        node->childCount = 0;
+        uint32_t node = arena_new_node(arena, source + tok.offset, tok.length);
+        if (node == NO_NODE) {
+            arena->outOfMemory = 1;
+            return NO_NODE;
+        }
+        uint32_t mark = arena->pendingCount;
 
-        while (pos < tokenCount && strcmp(tokens[pos], "(") == 0) {
+        while (pos < tokenCount && tokens[pos].kind == TOKEN_OPEN) {
             pos++; // "(" consume
-            Node *child;
-            while ((child = parse()) != NULL) {
-                node->children[node->childCount++] = child;
+            uint32_t child;
+            while ((child = parse(arena)) != NO_NODE) {
+                if (!arena_push_pending(arena, child)) arena->outOfMemory = 1;
             }
+            if (arena->outOfMemory) return NO_NODE;
+        }
+        if (!arena_attach_pending(arena, node, mark)) {
+            arena->outOfMemory = 1;
+            return NO_NODE;
         }
         return node;
     }
 }
 
-void dfs(Node *node, int idx) {
-    if (!node) return;
-    tree_array[idx] = strdup(node->value);
-    for (int j = 0; j < node->childCount; j++) {
-        dfs(node->children[j], idx * 2 + j);
+// 파싱하면서 함께 구하는 트리 통계 (빈 트리는 height -1)
+typedef struct {
+    int height;
+    int nodes;
+    int leaves;
+    int maxFanOut;
+} TreeStats;
+
+static void stats_init(TreeStats *stats) {
+    stats->height = -1;
+    stats->nodes = 0;
+    stats->leaves = 0;
+    stats->maxFanOut = 0;
+}
+
+// 노드 하나가 끝났을 때 통계에 반영하고 그 노드의 높이를 돌려준다
+static int stats_finish_node(TreeStats *stats, int childCount, int maxChildHeight) {
+    int height = childCount > 0 ? maxChildHeight + 1 : 0;
+    if (childCount == 0) stats->leaves++;
+    if (childCount > stats->maxFanOut) stats->maxFanOut = childCount;
+    return height;
+}
+
+// parse()와 같은 트리를 힙 스택으로 만든다. 프레임 = (노드, pending 시작 위치, 자식 최대 높이).
+// CALL: parse() 호출 시작, CHILDREN: 현재 노드 뒤의 "(" 확인, RETURN: 결과를 호출자에게 전달
+// stats가 NULL이 아니면 높이/노드 수/리프 수/최대 차수를 같은 패스에서 계산한다.
+// arena->hashConsing이면 끝난 서브트리마다 같은 노드가 있는지 찾아 공유한다 (결과는 DAG).
+// 메모리가 부족하면 arena->outOfMemory를 1로 하고 NO_NODE를 돌려준다 (빈 입력의 NO_NODE와 구별).
+typedef enum {
+    PARSE_CALL,
+    PARSE_CHILDREN,
+    PARSE_RETURN
+} ParseStep;
+
+uint32_t parse_iterative(NodeArena *arena, TreeStats *stats) {
+    GrowStack frames;
+    grow_stack_init(&frames);
+    ParseStep step = PARSE_CALL;
+    uint32_t result = NO_NODE;
+    int resultHeight = -1;
+    TreeStats local;
+    stats_init(&local);
+    arena->outOfMemory = 0;
+    arena->pendingCount = 0;    // 이전 파싱이 실패하고 남긴 자식 목록은 버린다
+
+    for (;;) {
+        if (step == PARSE_CALL) {
+            while (pos < tokenCount && tokens[pos].kind == TOKEN_OPEN) pos++;
+            result = NO_NODE;
+            step = PARSE_RETURN;
+            if (pos >= tokenCount) continue;
+
+            Token tok = tokens[pos++];
+            if (tok.kind == TOKEN_CLOSE) continue;
+            if (tok.kind == TOKEN_NODE) {
+                // 기존 서브트리를 그대로 자식으로 쓴다 (stats에는 세지 않으므로 증분 파싱은 stats 없이 호출)
+                result = arena->reuseNodes[tok.length];
+                // memo_reserve가 실패하면 통계 배열이 없으므로 다른 memo 사용처처럼 직접 센다
+                resultHeight = arena->memoHeight ? arena->memoHeight[result] : tree_height(arena, result);
+                continue;
+            }
+
+            uint32_t node = arena_new_node(arena, source + tok.offset, tok.length);
+            if (node == NO_NODE) {
+                arena->outOfMemory = 1;
+                break;
+            }
+            if (arena->recordSpans) arena_record_span(arena, node, tok.offset, -1);
+            local.nodes++;
+            if (!grow_stack_push(&frames, (int)node) || !grow_stack_push(&frames, (int)arena->pendingCount) ||
+                !grow_stack_push(&frames, -1)) {
+                arena->outOfMemory = 1;
+                break;
+            }
+            step = PARSE_CHILDREN;
+        } else if (step == PARSE_CHILDREN) {
+            if (pos < tokenCount && tokens[pos].kind == TOKEN_OPEN) {
+                pos++; // "(" consume
+                step = PARSE_CALL;
+                continue;
+            }
+            int maxChildHeight = grow_stack_pop(&frames);
+            uint32_t mark = (uint32_t)grow_stack_pop(&frames);
+            result = (uint32_t)grow_stack_pop(&frames);
+            resultHeight = stats_finish_node(&local, (int)(arena->pendingCount - mark), maxChildHeight);
+            // 마지막으로 소비한 토큰(라벨, 마지막 자식 그룹의 ')' 또는 재사용 서브트리)의 끝이 노드 구간의 끝
+            if (arena->recordSpans) {
+                const Token *last = &tokens[pos - 1];
+                int end = last->kind == TOKEN_NODE ? (int)arena->spanEnd[arena->reuseNodes[last->length]]
+                                                   : last->offset + last->length;
+                arena_record_span(arena, result, -1, end);
+            }
+            if (arena->hashConsing) result = arena_intern_pending(arena, result, mark);
+            else if (!arena_attach_pending(arena, result, mark)) result = NO_NODE;
+            if (result == NO_NODE) {
+                arena->outOfMemory = 1;
+                break;
+            }
+            step = PARSE_RETURN;
+        } else {
+            if (grow_stack_is_empty(&frames)) break;
+            if (result != NO_NODE) {
+                int *maxChildHeight = grow_stack_peek(&frames, 0);
+                if (resultHeight > *maxChildHeight) *maxChildHeight = resultHeight;
+                if (!arena_push_pending(arena, result)) {
+                    arena->outOfMemory = 1;
+                    break;
+                }
+                step = PARSE_CALL;
+            } else {
+                step = PARSE_CHILDREN;
+            }
+        }
+    }
+    grow_stack_free(&frames);
+
+    if (arena->outOfMemory) {
+        result = NO_NODE;
+        stats_init(&local);
+    }
+    if (result != NO_NODE) local.height = resultHeight;
+    if (stats) *stats = local;
+    return result;
+}
+
+// 입력 문자열을 64바이트씩 분류하며 토큰을 하나씩 꺼내는 커서 (토큰 배열을 만들지 않음)
+typedef struct {
+    const char *text;
+    size_t length;
+    size_t base;
+    SexprMasks masks;
+    uint64_t remaining;
+    int hasToken;
+    TokenKind kind;
+    size_t offset;
+} TokenCursor;
+
+// base 위치의 블록을 분류한다 (라벨은 시작 글자만 토큰; 앞 블록에서 이어지는 글자는 건너뜀)
+static void cursor_load(TokenCursor *cursor) {
+    size_t left = cursor->length - cursor->base;
+    uint64_t carry = cursor->base > 0 ? cursor->masks.label >> 63 : 0;
+    sexpr_classify_simd(cursor->text + cursor->base, left < SEXPR_BLOCK ? left : SEXPR_BLOCK, &cursor->masks);
+    cursor->remaining = cursor->masks.open | cursor->masks.close | label_starts(cursor->masks.label, carry);
+}
+
+static void cursor_init(TokenCursor *cursor, const char *text) {
+    cursor->text = text;
+    cursor->length = strlen(text);
+    cursor->base = 0;
+    cursor->remaining = 0;
+    cursor->hasToken = 0;
+    if (cursor->length > 0) cursor_load(cursor);
+}
+
+// 다음 토큰의 종류를 확인만 한다 (없으면 0)
+static int cursor_peek(TokenCursor *cursor, TokenKind *kind) {
+    if (!cursor->hasToken) {
+        while (cursor->remaining == 0) {
+            cursor->base += SEXPR_BLOCK;
+            if (cursor->base >= cursor->length) return 0;
+            cursor_load(cursor);
+        }
+        uint64_t bit = cursor->remaining & (~cursor->remaining + 1);
+        cursor->offset = cursor->base + (size_t)__builtin_ctzll(bit);
+        cursor->kind = (cursor->masks.open & bit) ? TOKEN_OPEN : (cursor->masks.close & bit) ? TOKEN_CLOSE : TOKEN_LABEL;
+        cursor->hasToken = 1;
     }
+    *kind = cursor->kind;
+    return 1;
+}
+
+static void cursor_advance(TokenCursor *cursor) {
+    cursor->remaining &= cursor->remaining - 1;
+    cursor->hasToken = 0;
 }
 
-void free_tree(Node *node) {
-    if (!node) return;
-    for (int i = 0; i < node->childCount; i++)
-        free_tree(node->children[i]);
-    free(node->children);
-    free(node);
+// 통계 전용 모드: parse_iterative와 같은 문법을 따라가되 노드와 토큰 배열을 만들지 않는다.
+// 프레임 = (자식 수, 자식 최대 높이)
+// succinct가 NULL이 아니면 노드가 열릴 때 '(' + 라벨, 닫힐 때 ')'를 덧붙여
+// 같은 패스에서 균형 괄호(BP) 표현을 만든다 (bp_finalize는 호출자가 수행).
+// 메모리가 부족하면 0을 돌려준다 (stats는 빈 트리로 초기화된다).
+int stats_only(const char *expr, TreeStats *stats, BpTree *succinct) {
+    TokenCursor cursor;
+    cursor_init(&cursor, expr);
+    GrowStack frames;
+    grow_stack_init(&frames);
+    ParseStep step = PARSE_CALL;
+    int found = 0;
+    int resultHeight = -1;
+    int ok = 1;
+    TokenKind kind;
+    stats_init(stats);
+
+    for (;;) {
+        if (step == PARSE_CALL) {
+            while (cursor_peek(&cursor, &kind) && kind == TOKEN_OPEN) cursor_advance(&cursor);
+            found = 0;
+            step = PARSE_RETURN;
+            if (!cursor_peek(&cursor, &kind)) continue;
+            cursor_advance(&cursor);
+            if (kind == TOKEN_CLOSE) continue;
+
+            stats->nodes++;
+            if ((succinct && !bp_append(succinct, 1, (unsigned char)expr[cursor.offset])) ||
+                !grow_stack_push(&frames, 0) || !grow_stack_push(&frames, -1)) {
+                ok = 0;
+                break;
+            }
+            step = PARSE_CHILDREN;
+        } else if (step == PARSE_CHILDREN) {
+            if (cursor_peek(&cursor, &kind) && kind == TOKEN_OPEN) {
+                cursor_advance(&cursor);
+                step = PARSE_CALL;
+                continue;
+            }
+            int maxChildHeight = grow_stack_pop(&frames);
+            int childCount = grow_stack_pop(&frames);
+            resultHeight = stats_finish_node(stats, childCount, maxChildHeight);
+            if (succinct && !bp_append(succinct, 0, 0)) {
+                ok = 0;
+                break;
+            }
+            found = 1;
+            step = PARSE_RETURN;
+        } else {
+            if (grow_stack_is_empty(&frames)) break;
+            if (found) {
+                int *maxChildHeight = grow_stack_peek(&frames, 0);
+                if (resultHeight > *maxChildHeight) *maxChildHeight = resultHeight;
+                (*grow_stack_peek(&frames, 1))++;
+                step = PARSE_CALL;
+            } else {
+                step = PARSE_CHILDREN;
+            }
+        }
+    }
+    grow_stack_free(&frames);
+    if (!ok) {
+        stats_init(stats);
+        return 0;
+    }
+    if (found) stats->height = resultHeight;
+    return 1;
+}
+
+// 병렬 통계: 서브트리 단위 작업을 공유 작업 큐에 넣고 스레드 풀이 나눠 처리한다 (fork-join).
+// 아레나의 노드는 전위 순서로 만들어지므로 노드 v의 서브트리는 [v, end) 구간이고,
+// i번째 자식의 end는 다음 자식의 번호(마지막 자식은 부모의 end)로 바로 알 수 있다.
+// 작업 안에서는 명시적 스택으로 순회하고(깊은 트리도 안전), 쉬는 스레드가 있을 때만
+// 크기가 PARALLEL_TASK_CUTOFF 이상인 대기 구간을 새 작업으로 내보낸다.
+// 높이는 리프 깊이의 최댓값, 노드/리프 수는 합이므로 스레드별 결과를 마지막에 한 번 합친다.
+#ifndef PARALLEL_TASK_CUTOFF
+#define PARALLEL_TASK_CUTOFF 4096
+#endif
+
+typedef struct {
+    uint32_t node;
+    uint32_t end;
+    int depth;
+} MetricTask;
+
+typedef struct {
+    const NodeArena *arena;
+    MetricTask *tasks;
+    size_t taskCount;
+    size_t taskCapacity;
+    int active;     // 작업을 처리 중인 스레드 수
+    int idle;       // 작업을 기다리는 스레드 수 (분할 여부 판단용)
+    int failed;     // 어느 작업이든 메모리가 부족해 서브트리를 다 세지 못했으면 1
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+} MetricPool;
+
+typedef struct {
+    MetricPool *pool;
+    TreeStats stats;
+    long long tasks;
+} MetricWorker;
+
+static int metric_pool_push(MetricPool *pool, MetricTask task) {
+    pthread_mutex_lock(&pool->lock);
+    if (pool->taskCount == pool->taskCapacity) {
+        size_t newCapacity = pool->taskCapacity ? pool->taskCapacity * 2 : 64;
+        MetricTask *grown = (MetricTask*)realloc(pool->tasks, sizeof(MetricTask) * newCapacity);
+        if (!grown) {
+            pthread_mutex_unlock(&pool->lock);
+            return 0;
+        }
+        pool->tasks = grown;
+        pool->taskCapacity = newCapacity;
+    }
+    pool->tasks[pool->taskCount] = task;
+    __atomic_store_n(&pool->taskCount, pool->taskCount + 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+    return 1;
+}
+
+// 작업 하나를 명시적 스택으로 순회한다. 쉬는 스레드가 있으면 스택 맨 아래 프레임
+// (루트에 가장 가까운, 아직 손대지 않은 가장 큰 구간)을 새 작업으로 내보낸다.
+// 스택을 키우지 못해 서브트리를 끝까지 세지 못하면 0을 돌려준다.
+static int metric_run_task(MetricPool *pool, MetricTask task, TreeStats *stats, GrowStack *frames) {
+    const NodeArena *arena = pool->arena;
+    size_t bottom = 0;
+    frames->count = 0;
+    if (!grow_stack_push(frames, (int)task.node) || !grow_stack_push(frames, (int)task.end) ||
+        !grow_stack_push(frames, task.depth)) return 0;
+
+    while (frames->count > bottom) {
+        // 큐에 쌓인 작업이 쉬는 스레드 수보다 적을 때만 내보낸다
+        if (frames->count - bottom >= 6 &&
+            __atomic_load_n(&pool->taskCount, __ATOMIC_RELAXED) < (size_t)__atomic_load_n(&pool->idle, __ATOMIC_RELAXED)) {
+            MetricTask donated = {(uint32_t)frames->items[bottom], (uint32_t)frames->items[bottom + 1],
+                                  frames->items[bottom + 2]};
+            if (donated.end > donated.node && donated.end - donated.node >= PARALLEL_TASK_CUTOFF &&
+                metric_pool_push(pool, donated)) {
+                bottom += 3;
+                continue;
+            }
+        }
+
+        int depth = grow_stack_pop(frames);
+        uint32_t end = (uint32_t)grow_stack_pop(frames);
+        uint32_t node = (uint32_t)grow_stack_pop(frames);
+        uint32_t childCount = arena->nodes[node].childCount;
+
+        stats->nodes++;
+        if (childCount > (uint32_t)stats->maxFanOut) stats->maxFanOut = (int)childCount;
+        if (childCount == 0) {
+            stats->leaves++;
+            if (depth > stats->height) stats->height = depth;
+            continue;
+        }
+
+        // 첫 자식이 맨 위에 오도록 거꾸로 넣는다
+        for (uint32_t i = childCount; i-- > 0;) {
+            uint32_t child = child_at(arena, node, i);
+            uint32_t childEnd = (i + 1 < childCount) ? child_at(arena, node, i + 1) : end;
+            if (!grow_stack_push(frames, (int)child) || !grow_stack_push(frames, (int)childEnd) ||
+                !grow_stack_push(frames, depth + 1)) return 0;
+        }
+    }
+    return 1;
+}
+
+static void *metric_worker(void *argument) {
+    MetricWorker *worker = (MetricWorker*)argument;
+    MetricPool *pool = worker->pool;
+    GrowStack frames;
+    grow_stack_init(&frames);
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->taskCount == 0 && pool->active > 0) {
+            __atomic_add_fetch(&pool->idle, 1, __ATOMIC_RELAXED);
+            pthread_cond_wait(&pool->ready, &pool->lock);
+            __atomic_sub_fetch(&pool->idle, 1, __ATOMIC_RELAXED);
+        }
+        if (pool->taskCount == 0) break;   // 큐가 비었고 처리 중인 작업도 없음 = 끝
+        MetricTask task = pool->tasks[pool->taskCount - 1];
+        __atomic_store_n(&pool->taskCount, pool->taskCount - 1, __ATOMIC_RELAXED);
+        pool->active++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (!metric_run_task(pool, task, &worker->stats, &frames)) __atomic_store_n(&pool->failed, 1, __ATOMIC_RELAXED);
+        worker->tasks++;
+
+        pthread_mutex_lock(&pool->lock);
+        pool->active--;
+        if (pool->active == 0 && pool->taskCount == 0) pthread_cond_broadcast(&pool->ready);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    grow_stack_free(&frames);
+    return NULL;
+}
+
+// 높이/노드 수/리프 수/최대 차수를 threadCount개 스레드로 계산 (tasks가 NULL이 아니면 처리한 작업 수)
+// 메모리가 부족해 일부 서브트리를 세지 못했으면 0을 돌려준다 (이때 stats는 믿을 수 없다).
+int tree_stats_parallel(const NodeArena *arena, uint32_t root, int threadCount, TreeStats *stats, long long *tasks) {
+    stats_init(stats);
+    if (tasks) *tasks = 0;
+    if (root == NO_NODE) return 1;
+    if (threadCount < 1) threadCount = 1;
+
+    MetricPool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.arena = arena;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.ready, NULL);
+    MetricTask first = {root, arena->nodeCount, 0};
+    pthread_t *threads = (pthread_t*)malloc(sizeof(pthread_t) * threadCount);
+    MetricWorker *workers = (MetricWorker*)calloc(threadCount, sizeof(MetricWorker));
+    if (!threads || !workers || !metric_pool_push(&pool, first)) {
+        free(workers);
+        free(threads);
+        free(pool.tasks);
+        pthread_cond_destroy(&pool.ready);
+        pthread_mutex_destroy(&pool.lock);
+        return 0;
+    }
+    for (int i = 0; i < threadCount; i++) {
+        workers[i].pool = &pool;
+        stats_init(&workers[i].stats);
+        pthread_create(&threads[i], NULL, metric_worker, &workers[i]);
+    }
+    for (int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+        if (workers[i].stats.height > stats->height) stats->height = workers[i].stats.height;
+        if (workers[i].stats.maxFanOut > stats->maxFanOut) stats->maxFanOut = workers[i].stats.maxFanOut;
+        stats->nodes += workers[i].stats.nodes;
+        stats->leaves += workers[i].stats.leaves;
+        if (tasks) *tasks += workers[i].tasks;
+    }
+
+    free(workers);
+    free(threads);
+    free(pool.tasks);
+    pthread_cond_destroy(&pool.ready);
+    pthread_mutex_destroy(&pool.lock);
+    return !pool.failed;
+}
+
+// 병렬 계산이 메모리 부족으로 실패하면 순차 계산으로 대신한다
+int tree_height_parallel(const NodeArena *arena, uint32_t root, int threadCount) {
+    TreeStats stats;
+    if (!tree_stats_parallel(arena, root, threadCount, &stats, NULL)) return tree_height(arena, root);
+    return stats.height;
+}
+
+int total_nodes_parallel(const NodeArena *arena, uint32_t root, int threadCount) {
+    TreeStats stats;
+    if (!tree_stats_parallel(arena, root, threadCount, &stats, NULL)) return total_nodes(arena, root);
+    return stats.nodes;
+}
+
+int leaf_nodes_parallel(const NodeArena *arena, uint32_t root, int threadCount) {
+    TreeStats stats;
+    if (!tree_stats_parallel(arena, root, threadCount, &stats, NULL)) return leaf_nodes(arena, root);
+    return stats.leaves;
+}
+
+// 구조 질의용 인덱스 (한 번 O(n log n)에 만들고 질의는 O(1)).
+// 오일러 투어: 노드에 들어갈 때와 각 자식에서 돌아올 때마다 노드를 적어 길이 2n-1의 배열을 만든다.
+//   lca(u, v)       = euler[first[u]..first[v]] 구간에서 깊이가 가장 얕은 노드 (희소 테이블 RMQ)
+//   u가 v의 조상    = first[u] <= first[v] && last[v] <= last[u]
+//   서브트리 크기   = (last[u] - first[u]) / 2 + 1
+//   거리            = depth[u] + depth[v] - 2 * depth[lca]
+// 해시 콘싱으로 만든 DAG에서는 노드 하나가 여러 위치에 있으므로 만들지 않는다.
+typedef struct {
+    uint32_t *euler;        // 길이 eulerLength
+    uint32_t eulerLength;
+    uint32_t *first;        // 노드별 오일러 위치 (처음/마지막)
+    uint32_t *last;
+    int *depth;
+    uint32_t *parent;       // 루트는 NO_NODE
+    uint32_t *sparse;       // sparse[k * eulerLength + i] = euler[i, i + 2^k)에서 가장 얕은 노드
+    int levels;
+} TreeQueryIndex;
+
+void query_index_free(TreeQueryIndex *index) {
+    free(index->euler);
+    free(index->first);
+    free(index->last);
+    free(index->depth);
+    free(index->parent);
+    free(index->sparse);
+    memset(index, 0, sizeof(*index));
+}
+
+static inline uint32_t query_shallower(const TreeQueryIndex *index, uint32_t a, uint32_t b) {
+    return index->depth[a] <= index->depth[b] ? a : b;
+}
+
+// 명시적 스택(프레임 = 노드, 다음 자식 번호)으로 오일러 투어를 만든 뒤 희소 테이블을 채운다
+int query_index_build(const NodeArena *arena, uint32_t root, TreeQueryIndex *index) {
+    memset(index, 0, sizeof(*index));
+    if (root == NO_NODE || arena->hashConsing) return 0;
+
+    uint32_t nodeCount = arena->nodeCount;
+    uint32_t capacity = 2 * nodeCount;
+    index->euler = (uint32_t*)malloc(sizeof(uint32_t) * capacity);
+    index->first = (uint32_t*)malloc(sizeof(uint32_t) * nodeCount);
+    index->last = (uint32_t*)malloc(sizeof(uint32_t) * nodeCount);
+    index->depth = (int*)malloc(sizeof(int) * nodeCount);
+    index->parent = (uint32_t*)malloc(sizeof(uint32_t) * nodeCount);
+    if (!index->euler || !index->first || !index->last || !index->depth || !index->parent) {
+        query_index_free(index);
+        return 0;
+    }
+
+    GrowStack frames;
+    grow_stack_init(&frames);
+    index->depth[root] = 0;
+    index->parent[root] = NO_NODE;
+    index->first[root] = 0;
+    index->euler[index->eulerLength++] = root;
+    int ok = grow_stack_push(&frames, (int)root) && grow_stack_push(&frames, 0);
+
+    while (ok && !grow_stack_is_empty(&frames)) {
+        uint32_t node = (uint32_t)*grow_stack_peek(&frames, 1);
+        int *next = grow_stack_peek(&frames, 0);
+        if ((uint32_t)*next < arena->nodes[node].childCount) {
+            uint32_t child = child_at(arena, node, (uint32_t)(*next)++);
+            index->depth[child] = index->depth[node] + 1;
+            index->parent[child] = node;
+            index->first[child] = index->eulerLength;
+            index->euler[index->eulerLength++] = child;
+            ok = grow_stack_push(&frames, (int)child) && grow_stack_push(&frames, 0);
+            continue;
+        }
+        index->last[node] = index->eulerLength - 1;
+        frames.count -= 2;
+        if (!grow_stack_is_empty(&frames)) {
+            index->euler[index->eulerLength++] = (uint32_t)*grow_stack_peek(&frames, 1);
+        }
+    }
+    grow_stack_free(&frames);
+    if (!ok) {
+        query_index_free(index);
+        return 0;
+    }
+
+    uint32_t length = index->eulerLength;
+    index->levels = 32 - __builtin_clz(length);
+    index->sparse = (uint32_t*)malloc(sizeof(uint32_t) * length * (size_t)index->levels);
+    if (!index->sparse) {
+        query_index_free(index);
+        return 0;
+    }
+    memcpy(index->sparse, index->euler, sizeof(uint32_t) * length);
+    for (int k = 1; k < index->levels; k++) {
+        const uint32_t *previous = index->sparse + (size_t)(k - 1) * length;
+        uint32_t *current = index->sparse + (size_t)k * length;
+        uint32_t half = 1u << (k - 1);
+        for (uint32_t i = 0; i + 2 * half <= length; i++) {
+            current[i] = query_shallower(index, previous[i], previous[i + half]);
+        }
+    }
+    return 1;
+}
+
+uint32_t query_lca(const TreeQueryIndex *index, uint32_t u, uint32_t v) {
+    uint32_t left = index->first[u], right = index->first[v];
+    if (left > right) {
+        uint32_t swap = left;
+        left = right;
+        right = swap;
+    }
+    int k = 31 - __builtin_clz(right - left + 1);
+    const uint32_t *level = index->sparse + (size_t)k * index->eulerLength;
+    return query_shallower(index, level[left], level[right + 1 - (1u << k)]);
+}
+
+int query_is_ancestor(const TreeQueryIndex *index, uint32_t ancestor, uint32_t node) {
+    return index->first[ancestor] <= index->first[node] && index->last[node] <= index->last[ancestor];
+}
+
+uint32_t query_subtree_size(const TreeQueryIndex *index, uint32_t node) {
+    return (index->last[node] - index->first[node]) / 2 + 1;
+}
+
+int query_distance(const TreeQueryIndex *index, uint32_t u, uint32_t v) {
+    return index->depth[u] + index->depth[v] - 2 * index->depth[query_lca(index, u, v)];
+}
+
+size_t query_index_bytes(const TreeQueryIndex *index, uint32_t nodeCount) {
+    return sizeof(uint32_t) * index->eulerLength * (size_t)(1 + index->levels) +
+           (sizeof(uint32_t) * 3 + sizeof(int)) * nodeCount;
+}
+
+void dfs(const NodeArena *arena, uint32_t node, int idx) {
+    if (node == NO_NODE || idx >= MAX_NODES) return;
+    tree_array[idx] = arena->nodes[node].label;
+    for (uint32_t j = 0; j < arena->nodes[node].childCount; j++) {
+        dfs(arena, child_at(arena, node, j), idx * 2 + j);
+    }
 }
 
 void made_tree(const char *expr) {
-    scanExpression(expr);
+    if (!scanExpression(expr)) {
+        printf("ERROR\n");
+        tokenCount = 0;
+        return;
+    }
     pos = 0;
-    Node *root = parse();
+    NodeArena arena;
+    arena_init(&arena);
+    arena.symbols = tree_symbols;   // 라벨은 아레나가 아니라 tree_symbols에 남는다
+    TreeStats stats;
+    uint32_t root = parse_iterative(&arena, &stats);
 
     for (int i = 0; i < MAX_NODES; i++)
-        tree_array[i] = NULL;
+        tree_array[i] = NO_SYMBOL;
+
+    if (arena.outOfMemory) {
+        printf("ERROR\n");
+    } else {
+        dfs(&arena, root, 1);
+        printf("%d, %d, %d\n", stats.height, stats.nodes, stats.leaves);
+    }
 
-    dfs(root, 1);
+    tree_symbols = arena.symbols;
+    memset(&arena.symbols, 0, sizeof(arena.symbols));
+    arena_free(&arena);
+    tokenCount = 0;
+}
 
-    printf("%d, %d, %d\n", tree_height(root), total_nodes(root), leaf_nodes(root));
+// 길이 제한 없이 한 줄을 읽음 (scanf(" %[^\n]")처럼 앞쪽 공백/빈 줄은 건너뜀)
+char *read_expression(FILE *fp) {
+    int ch;
+    while ((ch = fgetc(fp)) != EOF && isspace(ch)) {
+    }
+    if (ch == EOF) return NULL;
 
-    free_tree(root);
-    free_tokens();
+    size_t length = 0, capacity = 1024;
+    char *line = (char*)malloc(capacity);
+    if (!line) return NULL;
+    while (ch != EOF && ch != '\n') {
+        if (length + 1 == capacity) {
+            char *grown = (char*)realloc(line, capacity * 2);
+            if (!grown) {
+                free(line);
+                return NULL;
+            }
+            line = grown;
+            capacity *= 2;
+        }
+        line[length++] = (char)ch;
+        ch = fgetc(fp);
+    }
+    line[length] = '\0';
+    return line;
 }
 
-int main() {
-    char expr[MAX_LEN];
+// 아레나가 실제로 쓰는 바이트 수 (노드 + 자식 구간 + 심볼 표 + 해시 콘싱 테이블/노드별 통계)
+static size_t arena_used_bytes(const NodeArena *arena) {
+    size_t bytes = sizeof(Node) * arena->nodeCount + sizeof(uint32_t) * arena->childCount +
+                   symbol_table_bytes(&arena->symbols);
+    if (arena->consTable) bytes += sizeof(uint32_t) * arena->consCapacity;
+    if (arena->memoNodes) bytes += (sizeof(uint32_t) * 2 + sizeof(int)) * arena->nodeCount;
+    return bytes;
+}
 
-    if (scanf(" %[^\n]", expr) == 1) {
-        made_tree(expr);
+static void print_hash_cons_report(const NodeArena *arena, int treeNodes) {
+    size_t treeBytes = sizeof(Node) * (size_t)treeNodes + sizeof(uint32_t) * (size_t)(treeNodes > 0 ? treeNodes - 1 : 0);
+    size_t dagBytes = arena_used_bytes(arena);
+    printf("hash-consing: %u unique nodes for %d tree nodes (%u reused), %zu bytes vs %zu bytes as a tree (%.1f%% saved)\n",
+           arena->nodeCount, treeNodes, arena->sharedHits, dagBytes, treeBytes,
+           treeBytes ? 100.0 * ((double)treeBytes - (double)dagBytes) / (double)treeBytes : 0.0);
+}
+
+// 해시 콘싱 모드: 같은 서브트리를 공유하는 DAG로 파싱하고, 통계는 트리 기준으로 출력
+int run_hash_cons(FILE *fp) {
+    char *expr = read_expression(fp);
+    if (!expr) {
+        printf("ERROR\n");
+        return 0;
+    }
+    if (!scanExpression(expr)) {
+        printf("ERROR\n");
+        free(expr);
+        free(tokens);
+        return 1;
+    }
+    pos = 0;
+    NodeArena arena;
+    arena_init(&arena);
+    arena.hashConsing = 1;
+    TreeStats stats;
+    uint32_t root = parse_iterative(&arena, &stats);
+
+    if (arena.outOfMemory) {
+        printf("ERROR\n");
+    } else {
+        printf("%d, %d, %d\n", tree_height(&arena, root), total_nodes(&arena, root), leaf_nodes(&arena, root));
+        print_hash_cons_report(&arena, stats.nodes);
+    }
+
+    arena_free(&arena);
+    free(expr);
+    free(tokens);
+    return 0;
+}
+
+// 포인터 트리 없이 BP 표현만 만들어 질의로 통계를 다시 구하고 메모리 사용량을 보여준다
+int run_succinct(FILE *fp) {
+    char *expr = read_expression(fp);
+    if (!expr) {
+        printf("ERROR\n");
+        return 0;
+    }
+    TreeStats stats;
+    BpTree tree;
+    bp_init(&tree);
+    int parsed = stats_only(expr, &stats, &tree);
+    free(expr);
+    if (!parsed || !bp_finalize(&tree)) {
+        printf("ERROR\n");
+        bp_free(&tree);
+        return 1;
+    }
+
+    // 리프 = 첫 자식이 없는 노드, 높이 = 리프 깊이의 최댓값 (select로 노드를 차례로 방문)
+    long long height = -1, leaves = 0;
+    for (size_t k = 1; k <= tree.labelCount; k++) {
+        long long node = bp_select1(&tree, k);
+        if (bp_is_leaf(&tree, node)) {
+            leaves++;
+            if (bp_depth(&tree, node) > height) height = bp_depth(&tree, node);
+        }
+    }
+    long long root = bp_root(&tree);
+    printf("%lld, %lld, %lld\n", height, root == BP_NONE ? 0 : bp_subtree_size(&tree, root), leaves);
+    printf("succinct: %zu bits, %zu bytes (%.2f bits/node incl. labels)\n", tree.bitCount, bp_memory_bytes(&tree),
+           tree.labelCount ? 8.0 * (double)bp_memory_bytes(&tree) / (double)tree.labelCount : 0.0);
+
+    bp_free(&tree);
+    return 0;
+}
+
+static double elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// BP 표현은 노드당 라벨 1바이트이므로 모든 라벨이 한 글자일 때만 그대로 옮길 수 있다
+// (심볼마다 글자 + '\0'이 쌓이므로 한 글자 라벨뿐이면 바이트 수가 심볼 수의 두 배)
+static int arena_labels_fit_bp(const NodeArena *arena) {
+    return arena->symbols.bytesUsed == 2 * arena->symbols.count;
+}
+
+// 아레나 트리를 전위 순서로 걸으며 BP 비트열과 라벨 배열로 옮긴다 (프레임 = 노드, 다음 자식 번호)
+// 여러 글자 라벨이 있으면 잘라 쓰지 않고 실패한다
+int arena_to_bp(const NodeArena *arena, uint32_t root, BpTree *tree) {
+    bp_init(tree);
+    if (!arena_labels_fit_bp(arena)) return 0;
+    if (root != NO_NODE) {
+        GrowStack frames;
+        grow_stack_init(&frames);
+        int ok = bp_append(tree, 1, (unsigned char)symbol_name(&arena->symbols, arena->nodes[root].label)[0]) &&
+                 grow_stack_push(&frames, (int)root) && grow_stack_push(&frames, 0);
+
+        while (ok && !grow_stack_is_empty(&frames)) {
+            uint32_t node = (uint32_t)*grow_stack_peek(&frames, 1);
+            int *next = grow_stack_peek(&frames, 0);
+            if ((uint32_t)*next < arena->nodes[node].childCount) {
+                uint32_t child = child_at(arena, node, (uint32_t)(*next)++);
+                ok = bp_append(tree, 1, (unsigned char)symbol_name(&arena->symbols, arena->nodes[child].label)[0]) &&
+                     grow_stack_push(&frames, (int)child) && grow_stack_push(&frames, 0);
+            } else {
+                ok = bp_append(tree, 0, 0);
+                frames.count -= 2;
+            }
+        }
+        grow_stack_free(&frames);
+        if (!ok) return 0;
+    }
+    return bp_finalize(tree);
+}
+
+// BP 비트열을 한 번 훑어 높이/리프 수를 구한다 (리프 = '(' 바로 뒤가 ')')
+static void bp_scan_stats(const BpTree *tree, long long *height, long long *leaves) {
+    long long depth = 0;
+    *height = -1;
+    *leaves = 0;
+    for (size_t p = 0; p < tree->bitCount; p++) {
+        if (bp_bit(tree, p)) {
+            if (depth > *height) *height = depth;
+            depth++;
+            if (p + 1 == tree->bitCount || !bp_bit(tree, p + 1)) (*leaves)++;
+        } else {
+            depth--;
+        }
+    }
+}
+
+// 표준 입력의 트리를 파싱해 바이너리 파일로 저장
+int run_save(const char *path) {
+    char *expr = read_expression(stdin);
+    if (!expr) {
+        printf("ERROR\n");
+        return 0;
+    }
+    if (!scanExpression(expr)) {
+        printf("ERROR\n");
+        free(expr);
+        free(tokens);
+        return 1;
+    }
+    pos = 0;
+    NodeArena arena;
+    arena_init(&arena);
+    TreeStats stats;
+    uint32_t root = parse_iterative(&arena, &stats);
+
+    BpTree tree;
+    bp_init(&tree);
+    int ok = !arena.outOfMemory && arena_to_bp(&arena, root, &tree) && bp_save(&tree, path);
+    if (ok) {
+        printf("%d, %d, %d\n", stats.height, stats.nodes, stats.leaves);
+        printf("saved: %zu nodes, %zu bytes\n", tree.labelCount, bp_file_size(&tree));
+    } else if (arena.outOfMemory) {
+        printf("ERROR\n");
+    } else if (!arena_labels_fit_bp(&arena)) {
+        printf("ERROR: binary tree files hold one-letter labels only\n");
     } else {
+        printf("file write fail: %s\n", path);
+    }
+
+    bp_free(&tree);
+    arena_free(&arena);
+    free(expr);
+    free(tokens);
+    return ok ? 0 : 1;
+}
+
+// 저장된 파일을 mmap하고 Node를 만들지 않은 채 바로 질의한다.
+// 노드 수와 루트/자식 라벨은 헤더와 몇 페이지만 읽고, 높이/리프 수는 비트열을 한 번 훑는다.
+int run_load(const char *path) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    BpTree tree;
+    void *mapping;
+    size_t mappedSize;
+    if (!bp_map(&tree, path, &mapping, &mappedSize)) {
+        printf("file open fail: %s\n", path);
+        return 1;
+    }
+
+    long long root = bp_root(&tree);
+    long long children = 0;
+    printf("nodes: %zu\n", tree.labelCount);
+    if (root != BP_NONE) {
+        printf("root: %c, children:", bp_label(&tree, root));
+        for (long long child = bp_first_child(&tree, root); child != BP_NONE; child = bp_next_sibling(&tree, child)) {
+            printf(" %c", bp_label(&tree, child));
+            children++;
+        }
+        printf(" (%lld)\n", children);
+    }
+    fprintf(stderr, "first answer after %.6f s\n", elapsed_seconds(&start));
+
+    long long height, leaves;
+    bp_scan_stats(&tree, &height, &leaves);
+    printf("%lld, %zu, %lld\n", height, tree.labelCount, leaves);
+    fprintf(stderr, "full scan after %.6f s\n", elapsed_seconds(&start));
+
+    bp_unmap(&tree, mapping, mappedSize);
+    return 0;
+}
+
+// 텍스트 파싱과 바이너리 mmap 로드를 비교 (binaryPath에 저장한 뒤 다시 연다)
+int run_load_bench(const char *textPath, const char *binaryPath) {
+    FILE *fp = fopen(textPath, "r");
+    if (!fp) {
+        printf("file open fail: %s\n", textPath);
+        return 1;
+    }
+    char *expr = read_expression(fp);
+    fclose(fp);
+    if (!expr) {
+        printf("ERROR\n");
+        return 1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!scanExpression(expr)) {
+        printf("ERROR\n");
+        free(expr);
+        return 1;
+    }
+    pos = 0;
+    NodeArena arena;
+    arena_init(&arena);
+    uint32_t root = parse_iterative(&arena, NULL);
+    if (arena.outOfMemory) {
+        printf("ERROR\n");
+        arena_free(&arena);
+        free(expr);
+        return 1;
+    }
+    printf("parse text: %u nodes, %.6f s\n", arena.nodeCount, elapsed_seconds(&start));
+
+    BpTree tree;
+    if (!arena_to_bp(&arena, root, &tree) || !bp_save(&tree, binaryPath)) {
+        if (!arena_labels_fit_bp(&arena)) printf("ERROR: binary tree files hold one-letter labels only\n");
+        else printf("file write fail: %s\n", binaryPath);
+        bp_free(&tree);
+        arena_free(&arena);
+        free(expr);
+        return 1;
+    }
+    printf("binary: %zu bytes (text %zu bytes, arena %zu bytes)\n", bp_file_size(&tree), strlen(expr),
+           sizeof(Node) * arena.nodeCount + sizeof(uint32_t) * arena.childCount);
+    bp_free(&tree);
+    arena_free(&arena);
+    free(expr);
+    free(tokens);
+
+    void *mapping;
+    size_t mappedSize;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!bp_map(&tree, binaryPath, &mapping, &mappedSize)) {
+        printf("file open fail: %s\n", binaryPath);
+        return 1;
+    }
+    long long first = bp_first_child(&tree, bp_root(&tree));
+    printf("mmap + first child of root: %zu nodes, %.6f s\n", tree.labelCount, elapsed_seconds(&start));
+    long long height, leaves;
+    bp_scan_stats(&tree, &height, &leaves);
+    printf("full scan: height %lld, %lld leaves, %.6f s%s\n", height, leaves, elapsed_seconds(&start),
+           first == BP_NONE && tree.labelCount > 1 ? " (bad root)" : "");
+    bp_unmap(&tree, mapping, mappedSize);
+    return 0;
+}
+
+// 증분 파싱: 편집 (위치, 지운 길이, 넣을 문자열) 뒤에 편집 구간을 감싸는 가장 작은 서브트리만
+// 다시 토큰화/파싱하고, 노드별 통계(memo)는 루트까지의 경로에서만 고친다.
+// 노드 위치는 (앞 형제의 끝, 첫 자식이면 부모의 시작)부터의 거리 gap과 길이 length로 저장하므로
+// 편집 뒤 바뀌는 것은 경로 위 노드들의 length뿐이다.
+// 떼어 낸 옛 서브트리는 아레나에 남는다 (아레나는 추가만 함).
+typedef struct {
+    NodeArena arena;
+    uint32_t root;
+    char *text;
+    size_t textLength;
+    size_t textCapacity;
+    uint32_t *gap;          // 루트는 문서 시작부터의 거리
+    uint32_t *length;
+    uint32_t gapCapacity;
+    uint32_t lengthCapacity;
+    uint32_t *reuse;        // 다시 파싱할 때 그대로 쓰는 자식 서브트리 (TOKEN_NODE 순서)
+    uint32_t reuseCapacity;
+    uint32_t *siblingIndex; // 자식이 많은 노드의 자식 구간 합 트리 위치 (없으면 SIBLING_INDEX_NONE)
+    uint32_t siblingIndexCapacity;
+    SiblingIndexPool siblingSums;
+    long long reparsedBytes;    // 마지막 편집에서 다시 파싱한 바이트 수
+    int fullParses;
+} IncrementalTree;
+
+// 노드 [from, to)의 아레나 구간 기록(부분 문자열 기준)을 gap/length와 memo로 옮긴다.
+// 새로 파싱한 노드는 전위 순서로 번호가 붙으므로 큰 번호부터 보면 자식이 항상 먼저다.
+static int incremental_adopt(IncrementalTree *tree, uint32_t from, uint32_t to) {
+    NodeArena *arena = &tree->arena;
+    if (!grow_array((void**)&tree->gap, &tree->gapCapacity, to, sizeof(uint32_t)) ||
+        !grow_array((void**)&tree->length, &tree->lengthCapacity, to, sizeof(uint32_t)) ||
+        !grow_array((void**)&tree->siblingIndex, &tree->siblingIndexCapacity, to, sizeof(uint32_t)) ||
+        !memo_reserve(arena, to))
+        return 0;
+
+    for (uint32_t node = to; node-- > from;) {
+        const Node *n = &arena->nodes[node];
+        uint32_t cursor = arena->spanStart[node];
+        uint32_t nodes = 1, leaves = n->childCount == 0 ? 1 : 0;
+        int height = 0;
+        for (uint32_t i = 0; i < n->childCount; i++) {
+            uint32_t child = child_at(arena, node, i);
+            tree->gap[child] = arena->spanStart[child] - cursor;
+            cursor = arena->spanEnd[child];
+            nodes += arena->memoNodes[child];
+            leaves += arena->memoLeaves[child];
+            if (arena->memoHeight[child] + 1 > height) height = arena->memoHeight[child] + 1;
+        }
+        tree->length[node] = arena->spanEnd[node] - arena->spanStart[node];
+        arena->memoNodes[node] = nodes;
+        arena->memoLeaves[node] = leaves;
+        arena->memoHeight[node] = height;
+
+        tree->siblingIndex[node] = SIBLING_INDEX_NONE;
+        if (n->childCount < SIBLING_INDEX_MIN_CHILDREN) continue;
+        uint32_t base = sibling_index_alloc(&tree->siblingSums, n->childCount);
+        if (base == SIBLING_INDEX_NONE) continue;   // 자식 목록을 훑는 쪽으로 동작
+        for (uint32_t i = 0; i < n->childCount; i++) {
+            uint32_t child = child_at(arena, node, i);
+            tree->siblingSums.sums[base + i] = tree->gap[child] + tree->length[child];
+        }
+        sibling_index_finish(&tree->siblingSums, base, n->childCount);
+        tree->siblingIndex[node] = base;
+    }
+    return 1;
+}
+
+static int incremental_full_parse(IncrementalTree *tree) {
+    arena_free(&tree->arena);
+    arena_init(&tree->arena);
+    tree->arena.recordSpans = 1;
+    tree->siblingSums.used = 0;
+    tree->fullParses++;
+    tree->reparsedBytes = (long long)tree->textLength;
+
+    if (!scanExpression(tree->text)) return 0;
+    pos = 0;
+    tree->root = parse_iterative(&tree->arena, NULL);
+    if (tree->arena.outOfMemory) return 0;
+    if (tree->root == NO_NODE) return 1;
+    if (!incremental_adopt(tree, tree->root, tree->arena.nodeCount)) return 0;
+    tree->gap[tree->root] = tree->arena.spanStart[tree->root];
+    return 1;
+}
+
+int incremental_init(IncrementalTree *tree, const char *text) {
+    memset(tree, 0, sizeof(*tree));
+    arena_init(&tree->arena);
+    tree->textLength = strlen(text);
+    tree->textCapacity = tree->textLength + 1;
+    tree->text = (char*)malloc(tree->textCapacity);
+    if (!tree->text) return 0;
+    memcpy(tree->text, text, tree->textLength + 1);
+    return incremental_full_parse(tree);
+}
+
+void incremental_free(IncrementalTree *tree) {
+    arena_free(&tree->arena);
+    free(tree->text);
+    free(tree->gap);
+    free(tree->length);
+    free(tree->reuse);
+    free(tree->siblingIndex);
+    sibling_index_pool_free(&tree->siblingSums);
+    memset(tree, 0, sizeof(*tree));
+}
+
+// 편집된 노드 old의 새 구간 text[start, start + length)를 다시 파싱해 노드 하나가 구간 전체를 정확히 덮는지 확인한다.
+// old의 자식 중 편집 [offset, offset + deleted) 뒤에 있거나, 앞에 있으면서 끝난 뒤 편집 전에 다른 토큰이 오는
+// 서브트리는 토큰화하지 않고 TOKEN_NODE 하나로 넘긴다 (자식의 토큰과 바로 다음 토큰이 그대로이므로 파싱 결과도 같다).
+// 끝에 라벨 토큰 하나를 보초로 붙인다: 구간 안 그룹이 모두 닫혀 있으면 보초는 소비되지 않는다
+// (원래 파싱에서 이 노드 뒤의 토큰은 '('가 아니었고 그대로 남아 있으므로 결과가 같다).
+// 실패하면 새로 만든 노드를 되돌리고 NO_NODE.
+static uint32_t incremental_parse_region(IncrementalTree *tree, uint32_t old, size_t start, size_t length,
+                                         size_t offset, size_t deleted) {
+    NodeArena *arena = &tree->arena;
+    uint32_t nodeMark = arena->nodeCount, childMark = arena->childCount;
+    long long delta = (long long)length - (long long)tree->length[old];
+    // 구간 양 끝의 라벨이 바깥 라벨과 이어지면 구간만으로는 토큰이 정해지지 않는다
+    const char *text = tree->text;
+    if ((start > 0 && isalpha((unsigned char)text[start - 1]) && isalpha((unsigned char)text[start])) ||
+        (start + length < tree->textLength && isalpha((unsigned char)text[start + length - 1]) &&
+         isalpha((unsigned char)text[start + length])))
+        return NO_NODE;
+    uint32_t reuseCount = 0;
+    size_t scanned = 0;
+    size_t cursor = start;
+
+    tokenCount = 0;
+    source = tree->text + start;
+    for (uint32_t i = 0; i < arena->nodes[old].childCount; i++) {
+        uint32_t child = child_at(arena, old, i);
+        size_t childStart = cursor + tree->gap[child];
+        size_t childEnd = childStart + tree->length[child];
+        cursor = childEnd;
+
+        int after = childStart >= offset + deleted;
+        size_t next = childEnd;
+        while (!after && next < offset && isspace((unsigned char)tree->text[next])) next++;
+        if (!after && (childEnd > offset || next == offset)) continue;
+        if (!grow_array((void**)&tree->reuse, &tree->reuseCapacity, reuseCount + 1, sizeof(uint32_t))) break;
+
+        size_t relative = (size_t)((long long)childStart + (after ? delta : 0)) - start;
+        // 편집으로 앞에 라벨 글자가 붙었으면 자식의 첫 라벨이 늘어나므로 다시 토큰화한다
+        if (after && relative > 0 && isalpha((unsigned char)tree->text[start + relative - 1])) continue;
+        if (!scan_range(scanned, relative)) return NO_NODE;
+        tree->reuse[reuseCount] = child;
+        arena->spanStart[child] = (uint32_t)relative;
+        arena->spanEnd[child] = (uint32_t)(relative + tree->length[child]);
+        if (!push_token(TOKEN_NODE, (int)relative, (int)reuseCount++)) return NO_NODE;
+        tree->reparsedBytes += (long long)(relative - scanned);
+        scanned = relative + tree->length[child];
+    }
+    if (!scan_range(scanned, length)) return NO_NODE;
+    tree->reparsedBytes += (long long)(length - scanned);
+    if (!push_token(TOKEN_LABEL, (int)length, 0)) return NO_NODE;
+    pos = 0;
+    arena->reuseNodes = tree->reuse;
+
+    // 구간 전체가 재사용 서브트리 하나일 수도 있으므로 (예: 라벨을 지운 경우) 새 노드만 옮긴다
+    uint32_t node = parse_iterative(arena, NULL);
+    if (node != NO_NODE && pos == tokenCount - 1 && arena->spanStart[node] == 0 && arena->spanEnd[node] == length &&
+        incremental_adopt(tree, nodeMark, arena->nodeCount))
+        return node;
+
+    arena->nodeCount = nodeMark;
+    arena->childCount = childMark;
+    return NO_NODE;
+}
+
+// 자식 하나가 바뀐 조상의 길이/통계를 고치고 새 높이를 돌려준다.
+// 노드/리프 수는 차이만 더하고, 높이는 가장 높던 자식이 낮아졌을 때만 자식들을 다시 훑는다.
+static int incremental_refresh(IncrementalTree *tree, uint32_t node, long long lengthDelta, long long nodeDelta,
+                               long long leafDelta, int oldChildHeight, int newChildHeight) {
+    NodeArena *arena = &tree->arena;
+    tree->length[node] = (uint32_t)((long long)tree->length[node] + lengthDelta);
+    arena->memoNodes[node] = (uint32_t)((long long)arena->memoNodes[node] + nodeDelta);
+    arena->memoLeaves[node] = (uint32_t)((long long)arena->memoLeaves[node] + leafDelta);
+
+    int height = arena->memoHeight[node];
+    if (newChildHeight + 1 > height) {
+        height = newChildHeight + 1;
+    } else if (newChildHeight < oldChildHeight && oldChildHeight + 1 == height) {
+        height = 0;
+        for (uint32_t i = 0; i < arena->nodes[node].childCount; i++) {
+            uint32_t child = child_at(arena, node, i);
+            if (arena->memoHeight[child] + 1 > height) height = arena->memoHeight[child] + 1;
+        }
+    }
+    arena->memoHeight[node] = height;
+    return height;
+}
+
+// node(시작 cursor)의 자식 중 끝이 offset 이상인 첫 자식 번호와 그 시작 위치 (없으면 childCount)
+// 자식이 많은 노드는 구간 합 트리로 O(log 차수)에 찾고, 나머지는 자식 목록을 훑는다.
+static uint32_t incremental_find_child(const IncrementalTree *tree, uint32_t node, size_t cursor, size_t offset,
+                                       size_t *childStart) {
+    const NodeArena *arena = &tree->arena;
+    uint32_t childCount = arena->nodes[node].childCount;
+    if (tree->siblingIndex[node] != SIBLING_INDEX_NONE) {
+        size_t before = 0;
+        uint32_t i = offset > cursor ? sibling_index_find(&tree->siblingSums, tree->siblingIndex[node], childCount,
+                                                          offset - cursor - 1, &before) : 0;
+        if (i < childCount) *childStart = cursor + before + tree->gap[child_at(arena, node, i)];
+        return i;
+    }
+    for (uint32_t i = 0; i < childCount; i++) {
+        uint32_t child = child_at(arena, node, i);
+        size_t childEnd = cursor + tree->gap[child] + tree->length[child];
+        if (childEnd >= offset) {
+            *childStart = cursor + tree->gap[child];
+            return i;
+        }
+        cursor = childEnd;
+    }
+    return childCount;
+}
+
+// 편집을 적용한다. 반환값: 1 = 부분 재파싱, 2 = 전체 재파싱, 0 = 실패
+// 경로 스택(int)에 노드 시작 위치를 쌓으므로 문서가 MAX_SOURCE_LENGTH보다 길어지는 편집은 거부한다.
+int incremental_edit(IncrementalTree *tree, size_t offset, size_t deleted, const char *inserted) {
+    size_t insertedLength = strlen(inserted);
+    if (offset > tree->textLength || deleted > tree->textLength - offset) return 0;
+
+    size_t newLength = tree->textLength - deleted + insertedLength;
+    if (insertedLength > MAX_SOURCE_LENGTH || newLength > MAX_SOURCE_LENGTH) return 0;
+    if (newLength + 1 > tree->textCapacity) {
+        size_t newCapacity = tree->textCapacity * 2 > newLength + 1 ? tree->textCapacity * 2 : newLength + 1;
+        char *grown = (char*)realloc(tree->text, newCapacity);
+        if (!grown) return 0;
+        tree->text = grown;
+        tree->textCapacity = newCapacity;
+    }
+    memmove(tree->text + offset + insertedLength, tree->text + offset + deleted, tree->textLength - offset - deleted + 1);
+    memcpy(tree->text + offset, inserted, insertedLength);
+    tree->textLength = newLength;
+    tree->reparsedBytes = 0;
+    long long delta = (long long)insertedLength - (long long)deleted;
+
+    // 편집 구간 [offset, offset + deleted]를 감싸는 노드들을 루트부터 찾아 내려간다 (프레임 = 노드, 자식 번호, 시작)
+    GrowStack path;
+    grow_stack_init(&path);
+    NodeArena *arena = &tree->arena;
+    if (tree->root != NO_NODE) {
+        uint32_t node = tree->root;
+        size_t start = tree->gap[node];
+        int slot = -1;
+        while (start <= offset && offset + deleted <= start + tree->length[node]) {
+            if (!grow_stack_push(&path, (int)node) || !grow_stack_push(&path, slot) ||
+                !grow_stack_push(&path, (int)start)) break;
+            // 끝이 offset인 자식 바로 뒤에 붙은 형제도 후보다 (앞에서부터 훑을 때와 같은 자식을 고른다)
+            uint32_t childCount = arena->nodes[node].childCount;
+            size_t childStart = 0;
+            uint32_t next = NO_NODE;
+            for (uint32_t i = incremental_find_child(tree, node, start, offset, &childStart); i < childCount; i++) {
+                uint32_t child = child_at(arena, node, i);
+                if (childStart > offset) break;
+                if (offset + deleted <= childStart + tree->length[child]) {
+                    next = child;
+                    slot = (int)i;
+                    start = childStart;
+                    break;
+                }
+                if (i + 1 < childCount) childStart += tree->length[child] + tree->gap[child_at(arena, node, i + 1)];
+            }
+            if (next == NO_NODE) break;
+            node = next;
+        }
+    }
+
+    // 가장 깊은 노드부터 다시 파싱해 보고, 실패하면 부모로 올라간다
+    for (size_t level = path.count / 3; level-- > 0;) {
+        uint32_t node = (uint32_t)path.items[level * 3];
+        int slot = path.items[level * 3 + 1];
+        size_t start = (size_t)path.items[level * 3 + 2];
+        long long regionLength = (long long)tree->length[node] + delta;
+        if (regionLength <= 0) continue;
+
+        uint32_t replacement = incremental_parse_region(tree, node, start, (size_t)regionLength, offset, deleted);
+        if (replacement == NO_NODE) continue;
+
+        tree->gap[replacement] = tree->gap[node];
+        long long nodeDelta = (long long)arena->memoNodes[replacement] - arena->memoNodes[node];
+        long long leafDelta = (long long)arena->memoLeaves[replacement] - arena->memoLeaves[node];
+        if (level == 0) {
+            tree->root = replacement;
+        } else {
+            uint32_t parent = (uint32_t)path.items[(level - 1) * 3];
+            arena->children[arena->nodes[parent].firstChild + (uint32_t)slot] = replacement;
+            int oldHeight = arena->memoHeight[node], newHeight = arena->memoHeight[replacement];
+            for (size_t up = level; up-- > 0;) {
+                uint32_t ancestor = (uint32_t)path.items[up * 3];
+                int before = arena->memoHeight[ancestor];
+                newHeight = incremental_refresh(tree, ancestor, delta, nodeDelta, leafDelta, oldHeight, newHeight);
+                oldHeight = before;
+                if (tree->siblingIndex[ancestor] != SIBLING_INDEX_NONE)
+                    sibling_index_add(&tree->siblingSums, tree->siblingIndex[ancestor], arena->nodes[ancestor].childCount,
+                                      (uint32_t)path.items[(up + 1) * 3 + 1], delta);
+            }
+        }
+        grow_stack_free(&path);
+        return 1;
+    }
+    grow_stack_free(&path);
+    return incremental_full_parse(tree) ? 2 : 0;
+}
+
+// 편집 결과 트리가 비었으면 (노드가 하나도 없으면) ERROR
+static void print_incremental_stats(const IncrementalTree *tree) {
+    if (tree->root == NO_NODE) {
+        printf("ERROR\n");
+        return;
+    }
+    printf("%d, %d, %d\n", tree_height(&tree->arena, tree->root), total_nodes(&tree->arena, tree->root),
+           leaf_nodes(&tree->arena, tree->root));
+}
+
+// 첫 줄의 식을 파싱한 뒤 "위치 지울길이 넣을문자열" 형식의 편집 줄마다 통계를 다시 출력한다
+// (넣을 문자열은 두 번째 수 다음 공백 뒤의 나머지 전부, 비어 있어도 됨)
+int run_incremental(FILE *fp) {
+    char *expr = read_expression(fp);
+    if (!expr) {
         printf("ERROR\n");
+        return 0;
     }
+    IncrementalTree tree;
+    if (!incremental_init(&tree, expr)) {
+        printf("ERROR\n");
+        free(expr);
+        return 1;
+    }
+    free(expr);
+    print_incremental_stats(&tree);
 
-    for (int i = 0; i < MAX_NODES; i++) {
-        if (tree_array[i]) free(tree_array[i]);
+    char *line;
+    while ((line = read_expression(fp)) != NULL) {
+        char *cursor = line;
+        unsigned long offset = strtoul(cursor, &cursor, 10);
+        unsigned long deleted = strtoul(cursor, &cursor, 10);
+        if (*cursor == ' ') cursor++;
+        int result = incremental_edit(&tree, offset, deleted, cursor);
+        if (result == 0) {
+            printf("ERROR\n");
+        } else {
+            print_incremental_stats(&tree);
+            fprintf(stderr, "%s re-parse: %lld bytes\n", result == 1 ? "partial" : "full", tree.reparsedBytes);
+        }
+        free(line);
+    }
+    incremental_free(&tree);
+    free(tokens);
+    return 0;
+}
+
+// 재귀 parse와 parse_iterative 비교 (깊이가 너무 깊으면 재귀 버전은 생략)
+int run_parse_bench(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("file open fail: %s\n", path);
+        return 1;
+    }
+    char *expr = read_expression(fp);
+    fclose(fp);
+    if (!expr) {
+        printf("ERROR\n");
+        return 1;
+    }
+
+    long long maxDepth = sexpr_max_depth(expr, strlen(expr));
+    struct timespec start;
+    if (!scanExpression(expr)) {
+        printf("ERROR\n");
+        free(expr);
+        free(tokens);
+        return 1;
+    }
+    printf("input: %zu bytes, %d tokens, max depth %lld\n", strlen(expr), tokenCount, maxDepth);
+
+    if (maxDepth <= RECURSIVE_BENCH_DEPTH_LIMIT) {
+        NodeArena arena;
+        arena_init(&arena);
+        pos = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        parse(&arena);
+        if (arena.outOfMemory) printf("recursive: ERROR\n");
+        else printf("recursive: %u nodes, %.3f s\n", arena.nodeCount, elapsed_seconds(&start));
+        arena_free(&arena);
+    } else {
+        printf("recursive: skipped (depth > %d)\n", RECURSIVE_BENCH_DEPTH_LIMIT);
+    }
+
+    NodeArena arena;
+    arena_init(&arena);
+    pos = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TreeStats stats;
+    parse_iterative(&arena, &stats);
+    if (arena.outOfMemory) {
+        printf("iterative: ERROR\n");
+        arena_free(&arena);
+        free(expr);
+        free(tokens);
+        return 1;
+    }
+    printf("iterative: %u nodes, %.3f s\n", arena.nodeCount, elapsed_seconds(&start));
+    printf("labels: %u symbols, %zu bytes interned, %zu bytes of nodes\n", arena.symbols.count,
+           symbol_table_bytes(&arena.symbols), sizeof(Node) * arena.nodeCount);
+    arena_free(&arena);
+
+    arena_init(&arena);
+    arena.hashConsing = 1;
+    pos = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    parse_iterative(&arena, NULL);
+    if (arena.outOfMemory) {
+        printf("hash-consed: ERROR\n");
+    } else {
+        printf("hash-consed: %u nodes, %.3f s\n", arena.nodeCount, elapsed_seconds(&start));
+        print_hash_cons_report(&arena, stats.nodes);
+    }
+    arena_free(&arena);
+
+    free(expr);
+    free(tokens);
+    return 0;
+}
+
+static uint64_t bench_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// 벤치마크용 무작위 트리 텍스트 (노드 nodeCount개, 라벨은 한 글자)
+// 새 노드는 항상 현재 가장 오른쪽 경로의 어떤 노드의 마지막 자식이 된다.
+// wide: 0~2단계 올라간 뒤 붙여 차수가 크고 얕은 트리, deep: 대부분 바로 아래로 내려가 깊은 트리
+char *generate_tree_text(int nodeCount, int deep, uint64_t seed) {
+    size_t capacity = (size_t)nodeCount * 4 + 16;
+    char *text = (char*)malloc(capacity);
+    int *path = (int*)malloc(sizeof(int) * (nodeCount + 1));   // 경로 위 노드가 자식을 가졌는지
+    if (!text || !path) {
+        free(text);
+        free(path);
+        return NULL;
+    }
+    size_t length = 0;
+    int depth = 0;
+    uint64_t state = seed ? seed : 88172645463325252ULL;
+
+    for (int i = 0; i < nodeCount; i++) {
+        if (depth > 0) {
+            int pop;
+            if (deep) pop = (bench_random(&state) % 20 == 0) ? (int)(bench_random(&state) % (depth < 4 ? depth : 4)) : 0;
+            else pop = (int)(bench_random(&state) % (depth < 3 ? depth : 3));
+            for (int k = 0; k < pop; k++) {
+                if (path[--depth]) text[length++] = ')';
+            }
+            text[length++] = ' ';
+            if (!path[depth - 1]) {
+                text[length++] = '(';
+                path[depth - 1] = 1;
+            }
+        }
+        text[length++] = (char)('A' + i % 26);
+        path[depth++] = 0;
+    }
+    while (depth > 0) {
+        if (path[--depth]) text[length++] = ')';
+    }
+    text[length] = '\0';
+    free(path);
+    return text;
+}
+
+// 넓은/깊은 무작위 트리에서 순차 재귀 통계와 1..maxThreads 스레드 병렬 통계를 비교
+int run_metrics_bench(int nodeCount, int maxThreads) {
+    static const char *const shapes[] = {"wide", "deep"};
+    if (nodeCount < 1) nodeCount = 2000000;
+    if (maxThreads < 1) maxThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (maxThreads < 1) maxThreads = 1;
+
+    for (int deep = 0; deep <= 1; deep++) {
+        char *text = generate_tree_text(nodeCount, deep, 12345 + deep);
+        if (!text) {
+            printf("ERROR\n");
+            return 1;
+        }
+        if (!scanExpression(text)) {
+            printf("ERROR\n");
+            free(text);
+            free(tokens);
+            return 1;
+        }
+        struct timespec start;
+        NodeArena arena;
+        arena_init(&arena);
+        pos = 0;
+        TreeStats parsed;
+        uint32_t root = parse_iterative(&arena, &parsed);
+        if (arena.outOfMemory) {
+            printf("%s: ERROR\n", shapes[deep]);
+            arena_free(&arena);
+            free(text);
+            free(tokens);
+            return 1;
+        }
+        printf("%s: %d nodes, height %d, %d leaves, max fan-out %d\n", shapes[deep], parsed.nodes, parsed.height,
+               parsed.leaves, parsed.maxFanOut);
+
+        double sequential = 0.0;
+        if (parsed.height <= RECURSIVE_BENCH_DEPTH_LIMIT) {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            int height = tree_height(&arena, root);
+            int nodes = total_nodes(&arena, root);
+            int leaves = leaf_nodes(&arena, root);
+            sequential = elapsed_seconds(&start);
+            printf("  sequential: %d, %d, %d  %.4f s\n", height, nodes, leaves, sequential);
+        } else {
+            printf("  sequential: skipped (depth > %d)\n", RECURSIVE_BENCH_DEPTH_LIMIT);
+        }
+
+        double single = 0.0;
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            TreeStats stats;
+            long long tasks;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            int ok = tree_stats_parallel(&arena, root, threads, &stats, &tasks);
+            double seconds = elapsed_seconds(&start);
+            if (!ok) {
+                printf("  %2d threads: ERROR\n", threads);
+                break;
+            }
+            if (threads == 1) single = seconds;
+            int match = stats.height == parsed.height && stats.nodes == parsed.nodes && stats.leaves == parsed.leaves;
+            printf("  %2d threads: %d, %d, %d  %.4f s, %lld tasks, speedup %.2fx%s\n", threads, stats.height,
+                   stats.nodes, stats.leaves, seconds, tasks, seconds > 0 ? single / seconds : 0.0,
+                   match ? "" : "  MISMATCH");
+            if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+        }
+
+        arena_free(&arena);
+        free(text);
+    }
+    free(tokens);
+    return 0;
+}
+
+// 부모를 따라 올라가는 단순 LCA (검증용, O(깊이))
+static uint32_t naive_lca(const TreeQueryIndex *index, uint32_t u, uint32_t v) {
+    while (index->depth[u] > index->depth[v]) u = index->parent[u];
+    while (index->depth[v] > index->depth[u]) v = index->parent[v];
+    while (u != v) {
+        u = index->parent[u];
+        v = index->parent[v];
+    }
+    return u;
+}
+
+// 질의 인덱스를 만들고 무작위 노드 쌍으로 LCA/조상/거리 질의 처리량을 잰다.
+// 일부 질의는 부모를 따라 올라가는 방법과 스택 순회로 구한 서브트리 크기로 확인한다.
+int run_query_bench(const char *path, long long queryCount) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("file open fail: %s\n", path);
+        return 1;
+    }
+    char *expr = read_expression(fp);
+    fclose(fp);
+    if (!expr) {
+        printf("ERROR\n");
+        return 1;
+    }
+    if (queryCount < 1) queryCount = 10000000;
+
+    if (!scanExpression(expr)) {
+        printf("ERROR\n");
+        free(expr);
+        free(tokens);
+        return 1;
+    }
+    pos = 0;
+    NodeArena arena;
+    arena_init(&arena);
+    uint32_t root = parse_iterative(&arena, NULL);
+
+    struct timespec start;
+    TreeQueryIndex index;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (arena.outOfMemory || !query_index_build(&arena, root, &index)) {
+        printf("ERROR\n");
+        arena_free(&arena);
+        free(expr);
+        free(tokens);
+        return 1;
+    }
+    printf("index: %u nodes, euler %u, %d levels, %zu bytes, built in %.3f s\n", arena.nodeCount,
+           index.eulerLength, index.levels, query_index_bytes(&index, arena.nodeCount), elapsed_seconds(&start));
+
+    uint64_t state = 2463534242ULL;
+    int checks = 0, failures = 0;
+    for (int i = 0; i < 200; i++) {
+        uint32_t u = (uint32_t)(bench_random(&state) % arena.nodeCount);
+        uint32_t v = (uint32_t)(bench_random(&state) % arena.nodeCount);
+        uint32_t lca = query_lca(&index, u, v);
+        TreeStats sub;
+        if (!tree_stats_parallel(&arena, u, 1, &sub, NULL)) {
+            printf("ERROR\n");
+            query_index_free(&index);
+            arena_free(&arena);
+            free(expr);
+            free(tokens);
+            return 1;
+        }
+        failures += lca != naive_lca(&index, u, v);
+        failures += query_is_ancestor(&index, lca, u) != 1 || query_is_ancestor(&index, lca, v) != 1;
+        failures += query_subtree_size(&index, u) != (uint32_t)sub.nodes;
+        checks += 3;
+    }
+    printf("checked %d answers: %s\n", checks, failures ? "MISMATCH" : "ok");
+
+    long long checksum = 0;
+    state = 88172645463325252ULL;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long long q = 0; q < queryCount; q++) {
+        uint64_t r = bench_random(&state);
+        checksum += query_lca(&index, (uint32_t)(r % arena.nodeCount), (uint32_t)((r >> 32) % arena.nodeCount));
+    }
+    double seconds = elapsed_seconds(&start);
+    printf("lca: %lld queries, %.3f s, %.1f M/s (checksum %lld)\n", queryCount, seconds,
+           seconds > 0 ? queryCount / seconds / 1e6 : 0.0, checksum);
+
+    checksum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long long q = 0; q < queryCount; q++) {
+        uint64_t r = bench_random(&state);
+        uint32_t u = (uint32_t)(r % arena.nodeCount), v = (uint32_t)((r >> 32) % arena.nodeCount);
+        checksum += query_distance(&index, u, v) + query_is_ancestor(&index, u, v) + query_subtree_size(&index, u);
+    }
+    seconds = elapsed_seconds(&start);
+    printf("distance + is-ancestor + subtree size: %lld queries, %.3f s, %.1f M/s (checksum %lld)\n", queryCount,
+           seconds, seconds > 0 ? queryCount / seconds / 1e6 : 0.0, checksum);
+
+    query_index_free(&index);
+    arena_free(&arena);
+    free(expr);
+    free(tokens);
+    return failures ? 1 : 0;
+}
+
+// 무작위 편집(라벨 글자 바꾸기, 라벨 뒤에 자식 그룹 넣기, 넣었던 그룹 지우기)을 증분으로 적용하며
+// 편집당 시간과 다시 파싱한 바이트 수를 재고, 일부 편집은 전체 텍스트를 stats_only로 다시 세어 확인한다
+int run_incremental_bench(const char *path, int editCount) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("file open fail: %s\n", path);
+        return 1;
+    }
+    char *expr = read_expression(fp);
+    fclose(fp);
+    if (!expr) {
+        printf("ERROR\n");
+        return 1;
+    }
+    if (editCount < 1) editCount = 10000;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TreeStats full;
+    if (!stats_only(expr, &full, NULL)) {
+        printf("ERROR\n");
+        free(expr);
+        free(tokens);
+        return 1;
+    }
+    double fullSeconds = elapsed_seconds(&start);
+
+    IncrementalTree tree;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!incremental_init(&tree, expr)) {
+        printf("ERROR\n");
+        free(expr);
+        return 1;
+    }
+    printf("input: %zu bytes, %d nodes; full stats pass %.4f s, initial incremental parse %.4f s\n",
+           tree.textLength, full.nodes, fullSeconds, elapsed_seconds(&start));
+    free(expr);
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    long long reparsed = 0, inserted = 0;
+    int applied = 0, partial = 0, checks = 0, failures = 0;
+    double editSeconds = 0.0;
+    for (int e = 0; e < editCount; e++) {
+        // 무작위 위치에서 다음 라벨을 찾는다 (찾는 시간은 편집 시간에 넣지 않음)
+        size_t offset = (size_t)(bench_random(&state) % tree.textLength);
+        while (offset < tree.textLength && !isalpha((unsigned char)tree.text[offset])) offset++;
+        if (offset == tree.textLength) continue;
+
+        char replacement[2] = {(char)('A' + bench_random(&state) % 26), '\0'};
+        int kind = (int)(bench_random(&state) % 3);
+        size_t deleted = 1;
+        const char *text = replacement;
+        if (kind == 1) {
+            offset++;
+            deleted = 0;
+            text = " (Q)";
+            inserted++;
+        } else if (kind == 2 && inserted > 0 && offset + 4 <= tree.textLength &&
+                   memcmp(tree.text + offset - 1, " (Q)", 4) == 0) {
+            offset--;
+            deleted = 4;
+            text = "";
+            inserted--;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int result = incremental_edit(&tree, offset, deleted, text);
+        editSeconds += elapsed_seconds(&start);
+        if (result == 0) {
+            failures++;
+            continue;
+        }
+        applied++;
+        partial += result == 1;
+        reparsed += tree.reparsedBytes;
+
+        if (e % (editCount / 20 + 1) == 0) {
+            TreeStats check;
+            failures += !stats_only(tree.text, &check, NULL) || check.height != tree_height(&tree.arena, tree.root) ||
+                        check.nodes != total_nodes(&tree.arena, tree.root) ||
+                        check.leaves != leaf_nodes(&tree.arena, tree.root);
+            checks++;
+        }
+    }
+    double perEdit = applied ? editSeconds / applied : 0.0;
+    printf("%d edits: %d partial, %.2f us/edit, %.1f bytes re-parsed/edit, arena %u nodes\n", applied, partial,
+           perEdit * 1e6, applied ? (double)reparsed / applied : 0.0, tree.arena.nodeCount);
+    printf("full re-parse would cost %.1f us/edit (%.0fx)\n", fullSeconds * 1e6,
+           perEdit > 0 ? fullSeconds / perEdit : 0.0);
+    printf("checked %d snapshots against a full pass: %s\n", checks, failures ? "MISMATCH" : "ok");
+
+    incremental_free(&tree);
+    free(tokens);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "--bench-parse") == 0) {
+        return run_parse_bench(argv[2]);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-metrics") == 0) {
+        return run_metrics_bench(argc >= 3 ? atoi(argv[2]) : 0, argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--save") == 0) {
+        return run_save(argv[2]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--load") == 0) {
+        return run_load(argv[2]);
+    }
+    if (argc >= 4 && strcmp(argv[1], "--bench-load") == 0) {
+        return run_load_bench(argv[2], argv[3]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--bench-query") == 0) {
+        return run_query_bench(argv[2], argc >= 4 ? atoll(argv[3]) : 0);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--bench-incremental") == 0) {
+        return run_incremental_bench(argv[2], argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--incremental") == 0) {
+        return run_incremental(stdin);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--hash-cons") == 0) {
+        return run_hash_cons(stdin);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--succinct") == 0) {
+        return run_succinct(stdin);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--stats-only") == 0) {
+        char *expr = read_expression(stdin);
+        if (!expr) {
+            printf("ERROR\n");
+            return 0;
+        }
+        TreeStats stats;
+        if (stats_only(expr, &stats, NULL))
+            printf("%d, %d, %d, %d\n", stats.height, stats.nodes, stats.leaves, stats.maxFanOut);
+        else
+            printf("ERROR\n");
+        free(expr);
+        return 0;
+    }
+
+    char *expr = read_expression(stdin);
+
+    if (expr) {
+        made_tree(expr);
+    } else {
+        printf("ERROR\n");
     }
+    free(expr);
+    free(tokens);
+    symbol_table_free(&tree_symbols);
 
     return 0;
 }
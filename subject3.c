@@ -1,151 +1,1415 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "grow_stack.h"
+#include "sexpr_classify.h"
 
 #define TREE_SIZE 1024
+// 희소 모드의 힙 인덱스 상한 (깊이 61까지, 2i+1 계산이 long long을 넘지 않도록)
+#define SPARSE_INDEX_LIMIT (1LL << 62)
 
+// 희소 모드에서는 노드 수가 TREE_SIZE를 넘을 수 있으므로 가득 차면 두 배로 늘린다
 typedef struct {
-    int items[TREE_SIZE];
+    long long* items;
     int top;
+    int capacity;
 } Stack;
 void initStack(Stack* s) {
+    s->items = (long long*)malloc(sizeof(long long) * TREE_SIZE);
+    s->capacity = s->items != NULL ? TREE_SIZE : 0;
+    s->top = -1;
+}
+void freeStack(Stack* s) {
+    free(s->items);
+    s->items = NULL;
+    s->capacity = 0;
     s->top = -1;
 }
 bool isStackEmpty(Stack* s) {
     return s->top == -1;
 }
-void pushToStack(Stack* s, int item) {
-    if (s->top >= TREE_SIZE - 1) {
-        printf("Stack Overflow\n");
-        return;
+// 스택을 키우지 못하면 item을 넣지 않고 false (출력은 호출자가 한다)
+bool pushToStack(Stack* s, long long item) {
+    if (s->top >= s->capacity - 1) {
+        if (s->capacity > INT_MAX / 2) return false;
+        int newCapacity = s->capacity ? s->capacity * 2 : TREE_SIZE;
+        long long* grown = (long long*)realloc(s->items, sizeof(long long) * (size_t)newCapacity);
+        if (grown == NULL) return false;
+        s->items = grown;
+        s->capacity = newCapacity;
     }
     s->items[++s->top] = item;
+    return true;
 }
 
 // 스택에서 데이터를 꺼내는 함수
-int popFromStack(Stack* s) {
+long long popFromStack(Stack* s) {
     if (isStackEmpty(s)) {
         return -1;
     }
     return s->items[s->top--];
 }
 
-void iterativePreOrder(char treeArray[], int maxIndex) {
-    if (maxIndex < 1) return;
+// 트리 저장소: 힙 인덱스(i의 자식 2i, 2i+1) -> 라벨
+// 배열 모드는 기존 treeStoreGet(tree, TREE_SIZE) 그대로이고,
+// 희소 모드는 실제로 있는 노드만 오픈 어드레싱 해시(선형 탐사)에 저장한다.
+// 없는 인덱스는 '\0'을 돌려주므로 순회 함수는 두 모드에서 똑같이 동작한다.
+typedef struct {
+    bool sparse;
+    char* array;
+    long long arraySize;
+    unsigned long long* keys;   // 0 = 빈 칸 (힙 인덱스는 1부터)
+    char* labels;
+    size_t capacity;
+    size_t count;
+    long long droppedNodes;     // 인덱스 상한을 넘어 저장하지 못한 노드 수
+    long long failedNodes;      // 해시 표를 키우지 못해 저장하지 못한 노드 수
+} TreeStore;
+
+void initArrayStore(TreeStore* tree, char array[], long long arraySize) {
+    memset(tree, 0, sizeof(*tree));
+    tree->array = array;
+    tree->arraySize = arraySize;
+    for (long long i = 0; i < arraySize; ++i) array[i] = '\0';
+}
+
+// 메모리가 부족하면 false (이때도 freeTreeStore를 불러도 된다)
+bool initSparseStore(TreeStore* tree) {
+    memset(tree, 0, sizeof(*tree));
+    tree->sparse = true;
+    tree->keys = (unsigned long long*)calloc(64, sizeof(unsigned long long));
+    tree->labels = (char*)malloc(64);
+    if (tree->keys == NULL || tree->labels == NULL) {
+        free(tree->keys);
+        free(tree->labels);
+        tree->keys = NULL;
+        tree->labels = NULL;
+        return false;
+    }
+    tree->capacity = 64;
+    return true;
+}
+
+void freeTreeStore(TreeStore* tree) {
+    if (tree->sparse) {
+        free(tree->keys);
+        free(tree->labels);
+    }
+    memset(tree, 0, sizeof(*tree));
+}
+
+static size_t sparseSlot(const TreeStore* tree, unsigned long long key) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 17) & (tree->capacity - 1);
+}
+
+// 저장 가능한 인덱스인지 (배열 모드: TREE_SIZE 미만, 희소 모드: SPARSE_INDEX_LIMIT 미만)
+bool treeStoreCanHold(const TreeStore* tree, long long index) {
+    return tree->sparse ? index < SPARSE_INDEX_LIMIT : index < tree->arraySize;
+}
+
+char treeStoreGet(const TreeStore* tree, long long index) {
+    if (!tree->sparse) return (index >= 0 && index < tree->arraySize) ? tree->array[index] : '\0';
+
+    size_t slot = sparseSlot(tree, (unsigned long long)index);
+    while (tree->keys[slot] != 0) {
+        if (tree->keys[slot] == (unsigned long long)index) return tree->labels[slot];
+        slot = (slot + 1) & (tree->capacity - 1);
+    }
+    return '\0';
+}
+
+// 실패하면 기존 표를 그대로 둔다
+static bool growSparseStore(TreeStore* tree) {
+    size_t oldCapacity = tree->capacity;
+    unsigned long long* oldKeys = tree->keys;
+    char* oldLabels = tree->labels;
+
+    unsigned long long* keys = (unsigned long long*)calloc(oldCapacity * 2, sizeof(unsigned long long));
+    char* labels = (char*)malloc(oldCapacity * 2);
+    if (keys == NULL || labels == NULL) {
+        free(keys);
+        free(labels);
+        return false;
+    }
+
+    tree->capacity = oldCapacity * 2;
+    tree->keys = keys;
+    tree->labels = labels;
+    for (size_t i = 0; i < oldCapacity; ++i) {
+        if (oldKeys[i] == 0) continue;
+        size_t slot = sparseSlot(tree, oldKeys[i]);
+        while (tree->keys[slot] != 0) slot = (slot + 1) & (tree->capacity - 1);
+        tree->keys[slot] = oldKeys[i];
+        tree->labels[slot] = oldLabels[i];
+    }
+    free(oldKeys);
+    free(oldLabels);
+    return true;
+}
+
+// 희소 모드에서 표를 키우지 못하면 노드를 저장하지 않고 failedNodes에 센다
+void treeStoreSet(TreeStore* tree, long long index, char label) {
+    if (!tree->sparse) {
+        tree->array[index] = label;
+        return;
+    }
+    // 적재율 1/2 이하 유지
+    if ((tree->count + 1) * 2 > tree->capacity && !growSparseStore(tree)) {
+        tree->failedNodes++;
+        return;
+    }
+
+    size_t slot = sparseSlot(tree, (unsigned long long)index);
+    while (tree->keys[slot] != 0 && tree->keys[slot] != (unsigned long long)index) {
+        slot = (slot + 1) & (tree->capacity - 1);
+    }
+    if (tree->keys[slot] == 0) {
+        tree->keys[slot] = (unsigned long long)index;
+        tree->count++;
+    }
+    tree->labels[slot] = label;
+}
+
+size_t treeStoreBytes(const TreeStore* tree) {
+    return tree->sparse ? tree->capacity * (sizeof(unsigned long long) + 1) : (size_t)tree->arraySize;
+}
+
+// 아래 세 순회는 스택을 키우지 못하면 그 자리에서 멈추고 false를 돌려준다
+bool iterativePreOrder(const TreeStore* tree, long long maxIndex) {
+    if (maxIndex < 1) return true;
 
     Stack stack;
     initStack(&stack);
 
-    pushToStack(&stack, 1);
-    while (!isStackEmpty(&stack)) {
-        int currentIndex = popFromStack(&stack);
-        int rightChild = currentIndex * 2 + 1;
-        int leftChild = currentIndex * 2;
+    bool ok = pushToStack(&stack, 1);
+    while (ok && !isStackEmpty(&stack)) {
+        long long currentIndex = popFromStack(&stack);
+        long long rightChild = currentIndex * 2 + 1;
+        long long leftChild = currentIndex * 2;
 
-        if (currentIndex > maxIndex || !isalpha(treeArray[currentIndex])) continue;
-        printf("%c ", treeArray[currentIndex]);
-        if (rightChild <= maxIndex && isalpha(treeArray[rightChild])) pushToStack(&stack, rightChild);
-        if (leftChild <= maxIndex && isalpha(treeArray[leftChild])) pushToStack(&stack, leftChild);
+        if (currentIndex > maxIndex || !isalpha(treeStoreGet(tree, currentIndex))) continue;
+        printf("%c ", treeStoreGet(tree, currentIndex));
+        if (rightChild <= maxIndex && isalpha(treeStoreGet(tree, rightChild))) ok = pushToStack(&stack, rightChild);
+        if (ok && leftChild <= maxIndex && isalpha(treeStoreGet(tree, leftChild))) ok = pushToStack(&stack, leftChild);
     }
+    freeStack(&stack);
+    return ok;
 }
 
-void iterativeInOrder(char treeArray[], int maxIndex) {
+bool iterativeInOrder(const TreeStore* tree, long long maxIndex) {
     Stack stack;
     initStack(&stack);
 
-    int currentIndex = 1;
-    while ((currentIndex > 0 && currentIndex <= maxIndex && isalpha(treeArray[currentIndex])) || !isStackEmpty(&stack)) {
-        while (currentIndex > 0 && currentIndex <= maxIndex && isalpha(treeArray[currentIndex])) {
-            pushToStack(&stack, currentIndex);
+    long long currentIndex = 1;
+    while ((currentIndex > 0 && currentIndex <= maxIndex && isalpha(treeStoreGet(tree, currentIndex))) || !isStackEmpty(&stack)) {
+        while (currentIndex > 0 && currentIndex <= maxIndex && isalpha(treeStoreGet(tree, currentIndex))) {
+            if (!pushToStack(&stack, currentIndex)) {
+                freeStack(&stack);
+                return false;
+            }
             currentIndex = currentIndex * 2;
         }
         currentIndex = popFromStack(&stack);
         if (currentIndex != -1) {
-            printf("%c ", treeArray[currentIndex]);
+            printf("%c ", treeStoreGet(tree, currentIndex));
             currentIndex = currentIndex * 2 + 1;
         }
     }
+    freeStack(&stack);
+    return true;
 }
 
-void iterativePostOrder(char treeArray[], int maxIndex) {
-    if (maxIndex < 1) return;
+// 후위 순서는 s2를 다 채운 뒤에 출력하므로 실패하면 아무것도 출력하지 않는다
+bool iterativePostOrder(const TreeStore* tree, long long maxIndex) {
+    if (maxIndex < 1) return true;
 
     Stack s1, s2;
     initStack(&s1);
     initStack(&s2);
 
-    pushToStack(&s1, 1);
+    bool ok = pushToStack(&s1, 1);
 
-    while (!isStackEmpty(&s1)) {
-        int nodeIndex = popFromStack(&s1);
-        pushToStack(&s2, nodeIndex);
-        int leftChild = nodeIndex * 2;
-        int rightChild = nodeIndex * 2 + 1;
-        if (leftChild <= maxIndex && isalpha(treeArray[leftChild])) pushToStack(&s1, leftChild);
-        if (rightChild <= maxIndex && isalpha(treeArray[rightChild])) pushToStack(&s1, rightChild);
+    while (ok && !isStackEmpty(&s1)) {
+        long long nodeIndex = popFromStack(&s1);
+        ok = pushToStack(&s2, nodeIndex);
+        long long leftChild = nodeIndex * 2;
+        long long rightChild = nodeIndex * 2 + 1;
+        if (ok && leftChild <= maxIndex && isalpha(treeStoreGet(tree, leftChild))) ok = pushToStack(&s1, leftChild);
+        if (ok && rightChild <= maxIndex && isalpha(treeStoreGet(tree, rightChild))) ok = pushToStack(&s1, rightChild);
     }
 
-    while (!isStackEmpty(&s2)) {
-        int nodeIndex = popFromStack(&s2);
-        printf("%c ", treeArray[nodeIndex]);
+    while (ok && !isStackEmpty(&s2)) {
+        long long nodeIndex = popFromStack(&s2);
+        printf("%c ", treeStoreGet(tree, nodeIndex));
     }
+    freeStack(&s1);
+    freeStack(&s2);
+    return ok;
 }
 
+// Morris 순회용 연결 트리: 노드 번호는 1부터, 0은 "없음"
+// Morris 순회는 빈 오른쪽 링크에 중위 후속 노드를 잠시 걸어(스레드) 두었다가
+// 돌아올 때 풀기 때문에 순회 자체에는 보조 스택이 필요 없다. 힙 인덱스에는 바꿀 링크가 없으므로
+// 파서가 저장소 대신 O(n) 크기의 연결 트리를 바로 만들고(parseAndBuildLinkedTree) 그 위에서 순회한다.
+// 저장소 위에서 추가 메모리 없이 도는 순회는 TreeIterator (부모 = i/2)를 쓴다.
+typedef struct {
+    int left;
+    int right;
+    char label;
+} LinkedNode;
 
-void parseAndBuildTree(const char* inputString, int* stringIndex, char treeArray[], int treeIndex, int* maxTreeIndex) {
-    if (treeIndex >= TREE_SIZE) return;
+typedef struct {
+    LinkedNode* nodes;  // nodes[0]은 쓰지 않음
+    int count;
+    int capacity;
+} LinkedTree;
 
-    while (inputString[*stringIndex] && !isalpha(inputString[*stringIndex])) {
-        (*stringIndex)++;
+void freeLinkedTree(LinkedTree* linked) {
+    free(linked->nodes);
+    linked->nodes = NULL;
+    linked->count = 0;
+    linked->capacity = 0;
+}
+
+static int appendLinkedNode(LinkedTree* linked, char label) {
+    if (linked->count + 1 >= linked->capacity) {
+        int newCapacity = linked->capacity ? linked->capacity * 2 : 64;
+        LinkedNode* grown = (LinkedNode*)realloc(linked->nodes, sizeof(LinkedNode) * (size_t)newCapacity);
+        if (grown == NULL) return 0;
+        linked->nodes = grown;
+        linked->capacity = newCapacity;
+    }
+    int id = ++linked->count;
+    linked->nodes[id].left = 0;
+    linked->nodes[id].right = 0;
+    linked->nodes[id].label = label;
+    return id;
+}
+
+// 왼쪽 서브트리에서 가장 오른쪽 노드 (이미 current로 스레드가 걸려 있으면 그 직전 노드)
+static int morrisPredecessor(const LinkedTree* linked, int current) {
+    int predecessor = linked->nodes[current].left;
+    while (linked->nodes[predecessor].right != 0 && linked->nodes[predecessor].right != current) {
+        predecessor = linked->nodes[predecessor].right;
+    }
+    return predecessor;
+}
+
+void morrisPreOrder(LinkedTree* linked) {
+    LinkedNode* nodes = linked->nodes;
+    int current = linked->count > 0 ? 1 : 0;
+
+    while (current != 0) {
+        if (nodes[current].left == 0) {
+            printf("%c ", nodes[current].label);
+            current = nodes[current].right;
+            continue;
+        }
+        int predecessor = morrisPredecessor(linked, current);
+        if (nodes[predecessor].right == 0) {
+            printf("%c ", nodes[current].label);
+            nodes[predecessor].right = current;
+            current = nodes[current].left;
+        } else {
+            nodes[predecessor].right = 0;
+            current = nodes[current].right;
+        }
+    }
+}
+
+void morrisInOrder(LinkedTree* linked) {
+    LinkedNode* nodes = linked->nodes;
+    int current = linked->count > 0 ? 1 : 0;
+
+    while (current != 0) {
+        if (nodes[current].left == 0) {
+            printf("%c ", nodes[current].label);
+            current = nodes[current].right;
+            continue;
+        }
+        int predecessor = morrisPredecessor(linked, current);
+        if (nodes[predecessor].right == 0) {
+            nodes[predecessor].right = current;
+            current = nodes[current].left;
+        } else {
+            nodes[predecessor].right = 0;
+            printf("%c ", nodes[current].label);
+            current = nodes[current].right;
+        }
+    }
+}
+
+// from에서 오른쪽 링크를 따라 to까지의 경로를 뒤집는다
+static void reverseRightPath(LinkedNode nodes[], int from, int to) {
+    if (from == to) return;
+    int previous = from;
+    int current = nodes[from].right;
+    while (previous != to) {
+        int next = nodes[current].right;
+        nodes[current].right = previous;
+        previous = current;
+        current = next;
+    }
+}
+
+// 루트를 왼쪽 자식으로 갖는 더미 노드에서 시작해 중위 순회처럼 스레드를 걸고,
+// 스레드를 풀 때마다 current.left부터 전임 노드까지의 오른쪽 경로를 역순으로 출력한다.
+// 경로는 제자리에서 뒤집어 출력한 뒤 다시 뒤집어 되돌린다.
+// 더미 노드를 붙이지 못하면 아무것도 출력하지 않고 false
+bool morrisPostOrder(LinkedTree* linked) {
+    if (linked->count == 0) return true;
+    int dummy = appendLinkedNode(linked, '\0');
+    if (dummy == 0) return false;
+
+    LinkedNode* nodes = linked->nodes;
+    nodes[dummy].left = 1;
+    int current = dummy;
+
+    while (current != 0) {
+        if (nodes[current].left == 0) {
+            current = nodes[current].right;
+            continue;
+        }
+        int predecessor = morrisPredecessor(linked, current);
+        if (nodes[predecessor].right == 0) {
+            nodes[predecessor].right = current;
+            current = nodes[current].left;
+            continue;
+        }
+
+        nodes[predecessor].right = 0;
+        int first = nodes[current].left;
+        reverseRightPath(nodes, first, predecessor);
+        for (int node = predecessor;; node = nodes[node].right) {
+            printf("%c ", nodes[node].label);
+            if (node == first) break;
+        }
+        reverseRightPath(nodes, predecessor, first);
+        nodes[predecessor].right = 0;
+        current = nodes[current].right;
+    }
+    linked->count--;
+    return true;
+}
+
+
+// 당겨 쓰는(pull) 순회 반복자: next를 부를 때마다 다음 노드의 힙 인덱스를 하나 돌려준다.
+// 힙 인덱스에서는 부모가 i/2, 왼쪽/오른쪽 여부가 i의 짝홀이므로
+// 반복자 상태는 현재 인덱스 하나뿐이고, 중간에 멈춰도 남은 노드는 건드리지 않는다.
+typedef enum {
+    ORDER_PRE,
+    ORDER_IN,
+    ORDER_POST
+} TraversalOrder;
+
+typedef struct {
+    const TreeStore* tree;
+    long long maxIndex;
+    TraversalOrder order;
+    long long current;  // 마지막으로 돌려준 인덱스 (0 = 아직 시작 전)
+    bool done;
+} TreeIterator;
+
+static bool hasTreeNode(const TreeStore* tree, long long maxIndex, long long index) {
+    return index >= 1 && index <= maxIndex && isalpha(treeStoreGet(tree, index));
+}
+
+// index에서 왼쪽 자식만 따라 내려간 마지막 노드
+static long long leftmostNode(const TreeIterator* it, long long index) {
+    while (hasTreeNode(it->tree, it->maxIndex, index * 2)) index = index * 2;
+    return index;
+}
+
+// index 서브트리에서 후위 순회로 처음 방문하는 노드 (왼쪽 우선, 없으면 오른쪽으로 내려감)
+static long long firstPostOrderNode(const TreeIterator* it, long long index) {
+    for (;;) {
+        if (hasTreeNode(it->tree, it->maxIndex, index * 2)) index = index * 2;
+        else if (hasTreeNode(it->tree, it->maxIndex, index * 2 + 1)) index = index * 2 + 1;
+        else return index;
     }
-    if (inputString[*stringIndex] && isalpha(inputString[*stringIndex])) {
-        treeArray[treeIndex] = inputString[*stringIndex];
+}
+
+void initTreeIterator(TreeIterator* it, const TreeStore* tree, long long maxIndex, TraversalOrder order) {
+    it->tree = tree;
+    it->maxIndex = maxIndex;
+    it->order = order;
+    it->current = 0;
+    it->done = !hasTreeNode(tree, maxIndex, 1);
+}
+
+bool treeIteratorDone(const TreeIterator* it) {
+    return it->done;
+}
+
+// 다음 노드의 인덱스, 끝났으면 0
+long long treeIteratorNext(TreeIterator* it) {
+    if (it->done) return 0;
+
+    long long index = it->current;
+    long long next = 0;
+    if (index == 0) {
+        if (it->order == ORDER_PRE) next = 1;
+        else if (it->order == ORDER_IN) next = leftmostNode(it, 1);
+        else next = firstPostOrderNode(it, 1);
+    } else if (it->order == ORDER_PRE) {
+        if (hasTreeNode(it->tree, it->maxIndex, index * 2)) {
+            next = index * 2;
+        } else if (hasTreeNode(it->tree, it->maxIndex, index * 2 + 1)) {
+            next = index * 2 + 1;
+        } else {
+            // 오른쪽 형제가 있는 왼쪽 자식이 나올 때까지 올라간다
+            while (index > 1 && ((index & 1) || !hasTreeNode(it->tree, it->maxIndex, index + 1))) index /= 2;
+            next = index > 1 ? index + 1 : 0;
+        }
+    } else if (it->order == ORDER_IN) {
+        if (hasTreeNode(it->tree, it->maxIndex, index * 2 + 1)) {
+            next = leftmostNode(it, index * 2 + 1);
+        } else {
+            // 왼쪽 자식으로서 올라가는 첫 부모
+            while (index > 1 && (index & 1)) index /= 2;
+            next = index > 1 ? index / 2 : 0;
+        }
+    } else {
+        if (index == 1) next = 0;
+        else if (!(index & 1) && hasTreeNode(it->tree, it->maxIndex, index + 1)) next = firstPostOrderNode(it, index + 1);
+        else next = index / 2;
+    }
+
+    it->current = next;
+    if (next == 0) it->done = true;
+    return next;
+}
+
+// 중위 순회 k번째(1부터) 노드의 인덱스, 없으면 0
+long long findKthInOrder(const TreeStore* tree, long long maxIndex, long long k) {
+    TreeIterator it;
+    initTreeIterator(&it, tree, maxIndex, ORDER_IN);
+    long long index = 0;
+    while (k-- > 0 && !treeIteratorDone(&it)) index = treeIteratorNext(&it);
+    return k < 0 ? index : 0;
+}
+
+// order 순서에서 label을 가진 첫 노드의 인덱스, 없으면 0
+long long findFirstLabel(const TreeStore* tree, long long maxIndex, TraversalOrder order, char label) {
+    TreeIterator it;
+    initTreeIterator(&it, tree, maxIndex, order);
+    while (!treeIteratorDone(&it)) {
+        long long index = treeIteratorNext(&it);
+        if (index != 0 && treeStoreGet(tree, index) == label) return index;
+    }
+    return 0;
+}
+
+// 한 번의 순회로 세 순서를 모두 만든다.
+// 각 노드는 내려올 때(1번째), 왼쪽 서브트리를 마치고(2번째), 오른쪽 서브트리를 마치고(3번째)
+// 세 번 방문되며, 그 순간이 각각 전위/중위/후위 순서다.
+// 현재 위치는 힙 인덱스와 방문 단계만으로 표현되므로 스택이 필요 없다.
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} OrderBuffer;
+
+typedef enum {
+    VISIT_FIRST,
+    VISIT_SECOND,
+    VISIT_THIRD
+} VisitStage;
+
+static bool appendToOrderBuffer(OrderBuffer* buffer, char label) {
+    if (buffer->length + 3 > buffer->capacity) {
+        size_t newCapacity = buffer->capacity ? buffer->capacity * 2 : 256;
+        char* grown = (char*)realloc(buffer->data, newCapacity);
+        if (grown == NULL) return false;
+        buffer->data = grown;
+        buffer->capacity = newCapacity;
+    }
+    buffer->data[buffer->length++] = label;
+    buffer->data[buffer->length++] = ' ';
+    buffer->data[buffer->length] = '\0';
+    return true;
+}
+
+void freeOrderBuffer(OrderBuffer* buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+// orders[ORDER_PRE], orders[ORDER_IN], orders[ORDER_POST]에 "라벨 " 형식으로 채운다
+bool singleWalkTraversal(const TreeStore* tree, long long maxIndex, OrderBuffer orders[3]) {
+    for (int i = 0; i < 3; ++i) {
+        orders[i].data = NULL;
+        orders[i].length = 0;
+        orders[i].capacity = 0;
+    }
+    if (!hasTreeNode(tree, maxIndex, 1)) return true;
+
+    long long index = 1;
+    VisitStage stage = VISIT_FIRST;
+    for (;;) {
+        char label = treeStoreGet(tree, index);
+        if (stage == VISIT_FIRST) {
+            if (!appendToOrderBuffer(&orders[ORDER_PRE], label)) return false;
+            if (hasTreeNode(tree, maxIndex, index * 2)) {
+                index = index * 2;
+                continue;
+            }
+            stage = VISIT_SECOND;
+        }
+        if (stage == VISIT_SECOND) {
+            if (!appendToOrderBuffer(&orders[ORDER_IN], label)) return false;
+            if (hasTreeNode(tree, maxIndex, index * 2 + 1)) {
+                index = index * 2 + 1;
+                stage = VISIT_FIRST;
+                continue;
+            }
+        }
+        if (!appendToOrderBuffer(&orders[ORDER_POST], label)) return false;
+        if (index == 1) break;
+        // 왼쪽 자식에서 올라가면 부모의 2번째 방문, 오른쪽 자식에서 올라가면 3번째 방문
+        stage = (index & 1) ? VISIT_THIRD : VISIT_SECOND;
+        index /= 2;
+    }
+    return true;
+}
+
+// 순회 결과 한 줄("pre-order: A B C " 형식)을 라벨 목록으로 나눈 것.
+// 라벨 사이 공백을 '\0'으로 바꿔 labels[i]가 text 안의 문자열을 가리킨다.
+// 라벨은 여러 글자여도 된다 (큰 트리는 한 글자 라벨로 구별할 수 없으므로).
+typedef struct {
+    char* text;
+    char** labels;
+    int count;
+    int capacity;
+} LabelStream;
+
+void freeLabelStream(LabelStream* stream) {
+    free(stream->text);
+    free(stream->labels);
+    memset(stream, 0, sizeof(*stream));
+}
+
+// text의 소유권을 넘겨받는다. 첫 ':' 앞은 순서 이름으로 보고 건너뛴다.
+bool splitLabelStream(char* text, LabelStream* stream) {
+    memset(stream, 0, sizeof(*stream));
+    stream->text = text;
+    char* colon = strchr(text, ':');
+    char* cursor = colon != NULL ? colon + 1 : text;
+
+    for (;;) {
+        while (*cursor != '\0' && isspace((unsigned char)*cursor)) cursor++;
+        if (*cursor == '\0') return true;
+        if (stream->count == stream->capacity) {
+            int newCapacity = stream->capacity ? stream->capacity * 2 : 256;
+            char** grown = (char**)realloc(stream->labels, sizeof(char*) * (size_t)newCapacity);
+            if (grown == NULL) return false;
+            stream->labels = grown;
+            stream->capacity = newCapacity;
+        }
+        stream->labels[stream->count++] = cursor;
+        while (*cursor != '\0' && !isspace((unsigned char)*cursor)) cursor++;
+        if (*cursor != '\0') *cursor++ = '\0';
+    }
+}
+
+// 라벨 -> 중위 위치 해시 (오픈 어드레싱, 선형 탐사). slots에는 위치 + 1, 0 = 빈 칸
+typedef struct {
+    const LabelStream* inOrder;
+    int* slots;
+    size_t capacity;
+} PositionMap;
+
+static size_t labelSlot(const PositionMap* map, const char* label) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (const char* c = label; *c != '\0'; ++c) hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+    return (size_t)(hash ^ (hash >> 29)) & (map->capacity - 1);
+}
+
+// 같은 라벨이 두 번 나오면 트리가 하나로 정해지지 않으므로 false
+static bool buildPositionMap(PositionMap* map, const LabelStream* inOrder) {
+    map->inOrder = inOrder;
+    map->capacity = 64;
+    while (map->capacity < (size_t)inOrder->count * 2) map->capacity *= 2;
+    map->slots = (int*)calloc(map->capacity, sizeof(int));
+    if (map->slots == NULL) return false;
+
+    for (int position = 0; position < inOrder->count; ++position) {
+        size_t slot = labelSlot(map, inOrder->labels[position]);
+        while (map->slots[slot] != 0) {
+            if (strcmp(inOrder->labels[map->slots[slot] - 1], inOrder->labels[position]) == 0) return false;
+            slot = (slot + 1) & (map->capacity - 1);
+        }
+        map->slots[slot] = position + 1;
+    }
+    return true;
+}
+
+// label의 중위 위치, 없으면 -1
+static int findPosition(const PositionMap* map, const char* label) {
+    size_t slot = labelSlot(map, label);
+    while (map->slots[slot] != 0) {
+        int position = map->slots[slot] - 1;
+        if (strcmp(map->inOrder->labels[position], label) == 0) return position;
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+    return -1;
+}
+
+// 중위 순서와 전위(order == ORDER_PRE) 또는 후위(ORDER_POST) 순서로 연결 트리를 O(n)에 다시 만든다.
+// 전위 순서를 앞에서부터 보면서 스택에 "아직 오른쪽 자식을 받을 수 있는 노드"를 쌓는다:
+// 새 노드의 중위 위치가 스택 맨 위보다 앞이면 그 왼쪽 자식이고, 뒤이면 더 뒤에 있는 노드가 나올 때까지
+// 꺼낸 뒤 마지막으로 꺼낸 노드의 오른쪽 자식이다. 후위 순서를 뒤에서부터 보면 (루트, 오른쪽, 왼쪽)
+// 순서이므로 좌우와 비교 방향만 뒤집어 같은 방법을 쓴다.
+// 노드 번호는 만든 순서(1 = 루트), positions[번호]에 중위 위치를 적는다 (크기 count + 1).
+// 라벨이 겹치거나 두 순서가 한 트리에서 나올 수 없으면 false
+bool rebuildLinkedTree(const LabelStream* inOrder, const LabelStream* other, TraversalOrder order,
+                       LinkedTree* linked, int positions[]) {
+    linked->nodes = NULL;
+    linked->count = 0;
+    linked->capacity = 0;
+    int count = inOrder->count;
+    if (other->count != count) return false;
+    if (count == 0) return true;
+
+    bool mirror = order == ORDER_POST;
+    PositionMap map = {NULL, NULL, 0};
+    bool* used = (bool*)calloc((size_t)count, sizeof(bool));
+    linked->nodes = (LinkedNode*)malloc(sizeof(LinkedNode) * ((size_t)count + 2));  // 후위 Morris 순회의 더미 노드 자리까지
+    if (used == NULL || linked->nodes == NULL || !buildPositionMap(&map, inOrder)) {
+        free(used);
+        free(map.slots);
+        return false;
+    }
+    linked->capacity = count + 2;
+
+    GrowStack stack;
+    grow_stack_init(&stack);
+    // 지금까지 꺼낸 노드의 중위 위치 중 가장 최근 것: 이후 노드는 모두 그 뒤(mirror면 앞)여야 한다
+    int bound = mirror ? count : -1;
+    bool ok = true;
+    for (int k = 0; ok && k < count; ++k) {
+        const char* label = other->labels[mirror ? count - 1 - k : k];
+        int position = findPosition(&map, label);
+        if (position < 0 || used[position] || (mirror ? position > bound : position < bound)) {
+            ok = false;
+            break;
+        }
+        used[position] = true;
+        int id = appendLinkedNode(linked, label[0]);
+        positions[id] = position;
+
+        if (k > 0) {
+            int top = *grow_stack_peek(&stack, 0);
+            if (mirror ? position > positions[top] : position < positions[top]) {
+                if (mirror) linked->nodes[top].right = id;
+                else linked->nodes[top].left = id;
+            } else {
+                int parent;
+                do {
+                    parent = grow_stack_pop(&stack);
+                } while (!grow_stack_is_empty(&stack) &&
+                         (mirror ? position < positions[*grow_stack_peek(&stack, 0)]
+                                 : position > positions[*grow_stack_peek(&stack, 0)]));
+                if (mirror) linked->nodes[parent].left = id;
+                else linked->nodes[parent].right = id;
+                bound = positions[parent];
+            }
+        }
+        ok = grow_stack_push(&stack, id);
+    }
+
+    grow_stack_free(&stack);
+    free(map.slots);
+    free(used);
+    return ok;
+}
+
+// 연결 트리의 노드 번호를 전위(또는 후위) 순서로 ids에 채운다.
+// 후위 순서는 (루트, 오른쪽, 왼쪽) 순서를 거꾸로 채운 것이다.
+bool listLinkedTree(const LinkedTree* linked, TraversalOrder order, int ids[]) {
+    if (linked->count == 0) return true;
+    bool post = order == ORDER_POST;
+    GrowStack stack;
+    grow_stack_init(&stack);
+
+    bool ok = grow_stack_push(&stack, 1);
+    for (int k = 0; ok && !grow_stack_is_empty(&stack); ++k) {
+        int id = grow_stack_pop(&stack);
+        ids[post ? linked->count - 1 - k : k] = id;
+        // 나중에 방문할 쪽을 먼저 넣는다
+        int later = post ? linked->nodes[id].left : linked->nodes[id].right;
+        int sooner = post ? linked->nodes[id].right : linked->nodes[id].left;
+        if (later != 0) ok = grow_stack_push(&stack, later);
+        if (ok && sooner != 0) ok = grow_stack_push(&stack, sooner);
+    }
+    grow_stack_free(&stack);
+    return ok;
+}
+
+// 입력 전체를 미리 64바이트 단위 비트마스크로 분류해 두고(index),
+// "다음 라벨 / 다음 ')' / 다음 비공백 위치"를 비트 스캔으로 찾는다.
+// 저장소가 담을 수 없는 인덱스의 노드는 버리고 droppedNodes에 센다.
+void parseAndBuildTree(const char* inputString, const SexprIndex* index, size_t* stringIndex, TreeStore* tree, long long treeIndex, long long* maxTreeIndex) {
+    if (!treeStoreCanHold(tree, treeIndex)) {
+        tree->droppedNodes++;
+        return;
+    }
+
+    *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_LABEL);
+    if (*stringIndex < index->length) {
+        treeStoreSet(tree, treeIndex, inputString[*stringIndex]);
         if (treeIndex > *maxTreeIndex) {
             *maxTreeIndex = treeIndex;
         }
         (*stringIndex)++;
     }
 
-    while (inputString[*stringIndex] && isspace(inputString[*stringIndex])) {
-        (*stringIndex)++;
-    }
+    *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_NONSPACE);
     if (inputString[*stringIndex] == '(') {
         (*stringIndex)++;
-        parseAndBuildTree(inputString, stringIndex, treeArray, treeIndex * 2, maxTreeIndex);
-        while (inputString[*stringIndex] && isspace(inputString[*stringIndex])) {
+        parseAndBuildTree(inputString, index, stringIndex, tree, treeIndex * 2, maxTreeIndex);
+        *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_NONSPACE);
+        if (inputString[*stringIndex] != ')') {
+            parseAndBuildTree(inputString, index, stringIndex, tree, treeIndex * 2 + 1, maxTreeIndex);
+        }
+        *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_CLOSE);
+        if (inputString[*stringIndex] == ')') {
+             (*stringIndex)++;
+        }
+    }
+}
+
+
+// parseAndBuildTree와 같은 동작을 힙 스택으로 수행
+// 스택에는 진행 단계만 두고, 현재 트리 인덱스는 내려갈 때 2i / 2i+1, 올라올 때 i/2로 계산한다.
+// 단계 0: 라벨 읽기, 1: 왼쪽 자식 처리 후, 2: 오른쪽 자식 처리 후
+// 스택을 키우지 못해 입력을 끝까지 읽지 못하면 false
+bool parseAndBuildTreeIterative(const char* inputString, const SexprIndex* index, size_t* stringIndex, TreeStore* tree, long long* maxTreeIndex) {
+    GrowStack frames;
+    long long treeIndex = 1;
+    grow_stack_init(&frames);
+    bool ok = grow_stack_push(&frames, 0);
+
+    while (ok && !grow_stack_is_empty(&frames)) {
+        int* phase = grow_stack_peek(&frames, 0);
+
+        if (*phase == 0) {
+            if (!treeStoreCanHold(tree, treeIndex)) {
+                tree->droppedNodes++;
+                frames.count--;
+                treeIndex /= 2;
+                continue;
+            }
+            *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_LABEL);
+            if (*stringIndex < index->length) {
+                treeStoreSet(tree, treeIndex, inputString[*stringIndex]);
+                if (treeIndex > *maxTreeIndex) {
+                    *maxTreeIndex = treeIndex;
+                }
+                (*stringIndex)++;
+            }
+            *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_NONSPACE);
+            if (inputString[*stringIndex] != '(') {
+                frames.count--;
+                treeIndex /= 2;
+                continue;
+            }
             (*stringIndex)++;
+            *phase = 1;
+            if (!(ok = grow_stack_push(&frames, 0))) break;
+            treeIndex = treeIndex * 2;
+            continue;
         }
-        if (inputString[*stringIndex] != ')') {
-            parseAndBuildTree(inputString, stringIndex, treeArray, treeIndex * 2 + 1, maxTreeIndex);
+
+        if (*phase == 1) {
+            *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_NONSPACE);
+            *phase = 2;
+            if (inputString[*stringIndex] != ')') {
+                if (!(ok = grow_stack_push(&frames, 0))) break;
+                treeIndex = treeIndex * 2 + 1;
+                continue;
+            }
+        }
+
+        *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_CLOSE);
+        if (inputString[*stringIndex] == ')') {
+            (*stringIndex)++;
         }
-        while (inputString[*stringIndex] && inputString[*stringIndex] != ')') {
+        frames.count--;
+        treeIndex /= 2;
+    }
+    grow_stack_free(&frames);
+    return ok;
+}
+
+// parseAndBuildTreeIterative와 같은 트리를 저장소 대신 연결 트리로 만든다 (Morris 순회용).
+// 프레임은 (노드 번호, 단계) 두 칸이고, 노드 번호 0은 트리에 들어가지 않는 노드다
+// (라벨이 없거나 그런 노드의 자손). 힙 인덱스는 저장소와 같은 노드를 버리기 위해서만 따라간다:
+// indexLimit 이상인 노드는 버리고 droppedNodes에 센다.
+// 메모리가 부족해 입력을 끝까지 읽지 못하면 false
+bool parseAndBuildLinkedTree(const char* inputString, const SexprIndex* index, size_t* stringIndex,
+                             long long indexLimit, LinkedTree* linked, long long* droppedNodes) {
+    GrowStack frames;
+    long long treeIndex = 1;
+    linked->nodes = NULL;
+    linked->count = 0;
+    linked->capacity = 0;
+    grow_stack_init(&frames);
+    bool ok = grow_stack_push(&frames, 0) && grow_stack_push(&frames, 0);
+
+    while (ok && !grow_stack_is_empty(&frames)) {
+        int* phase = grow_stack_peek(&frames, 0);
+
+        if (*phase == 0) {
+            if (treeIndex >= indexLimit) {
+                (*droppedNodes)++;
+                frames.count -= 2;
+                treeIndex /= 2;
+                continue;
+            }
+            // 부모가 트리에 있을 때만 (루트는 부모 없이) 노드를 만들어 부모의 왼쪽/오른쪽에 건다
+            int parent = frames.count > 2 ? *grow_stack_peek(&frames, 3) : 0;
+            *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_LABEL);
+            if (*stringIndex < index->length) {
+                if (treeIndex == 1 || parent != 0) {
+                    int id = appendLinkedNode(linked, inputString[*stringIndex]);
+                    if (id == 0) {
+                        ok = false;
+                        break;
+                    }
+                    *grow_stack_peek(&frames, 1) = id;
+                    if (parent != 0) {
+                        if (treeIndex & 1) linked->nodes[parent].right = id;
+                        else linked->nodes[parent].left = id;
+                    }
+                }
+                (*stringIndex)++;
+            }
+            *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_NONSPACE);
+            if (inputString[*stringIndex] != '(') {
+                frames.count -= 2;
+                treeIndex /= 2;
+                continue;
+            }
             (*stringIndex)++;
+            *phase = 1;
+            if (!(ok = grow_stack_push(&frames, 0) && grow_stack_push(&frames, 0))) break;
+            treeIndex = treeIndex * 2;
+            continue;
         }
+
+        if (*phase == 1) {
+            *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_NONSPACE);
+            *phase = 2;
+            if (inputString[*stringIndex] != ')') {
+                if (!(ok = grow_stack_push(&frames, 0) && grow_stack_push(&frames, 0))) break;
+                treeIndex = treeIndex * 2 + 1;
+                continue;
+            }
+        }
+
+        *stringIndex = sexpr_find_next(index, *stringIndex, SEXPR_FIND_CLOSE);
         if (inputString[*stringIndex] == ')') {
-             (*stringIndex)++;
+            (*stringIndex)++;
         }
+        frames.count -= 2;
+        treeIndex /= 2;
     }
+    grow_stack_free(&frames);
+    return ok;
 }
 
+static double elapsedSeconds(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
 
-int main(void) {
-    char inputString[TREE_SIZE];
-    char treeArray[TREE_SIZE];
-    int stringPosition = 0;
-    int maxUsedIndex = 0;
+// 재귀 파서와 명시적 스택 파서 비교 (결과 배열이 같은지도 확인)
+// 희소 저장소로도 한 번 더 파싱해 노드 수와 메모리 사용량을 출력
+int runParseBench(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        printf("file open fail: %s\n", path);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* input = (char*)malloc((size_t)size + 1);
+    size_t length = fread(input, 1, (size_t)size, fp);
+    input[length] = '\0';
+    fclose(fp);
+
+    static char recursiveArray[TREE_SIZE], iterativeArray[TREE_SIZE];
+    TreeStore recursiveTree, iterativeTree, sparseTree;
+    long long maxDepth = sexpr_max_depth(input, length);
+    struct timespec start;
+    SexprIndex index;
+    sexpr_index_build(&index, input, length, sexpr_classify_simd);
+    initArrayStore(&recursiveTree, recursiveArray, TREE_SIZE);
+    initArrayStore(&iterativeTree, iterativeArray, TREE_SIZE);
+    if (!initSparseStore(&sparseTree)) {
+        printf("out of memory\n");
+        sexpr_index_free(&index);
+        free(input);
+        return 1;
+    }
+
+    printf("input: %zu bytes, max depth %lld\n", length, maxDepth);
+    if (maxDepth <= RECURSIVE_BENCH_DEPTH_LIMIT) {
+        size_t position = 0;
+        long long maxUsedIndex = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        parseAndBuildTree(input, &index, &position, &recursiveTree, 1, &maxUsedIndex);
+        printf("recursive: max index %lld, %.6f s\n", maxUsedIndex, elapsedSeconds(&start));
+    } else {
+        printf("recursive: skipped (depth > %d)\n", RECURSIVE_BENCH_DEPTH_LIMIT);
+    }
+
+    size_t position = 0;
+    long long maxUsedIndex = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool parsed = parseAndBuildTreeIterative(input, &index, &position, &iterativeTree, &maxUsedIndex);
+    printf("iterative: %s, max index %lld, %.6f s\n", parsed ? "ok" : "out of memory", maxUsedIndex, elapsedSeconds(&start));
+    if (maxDepth <= RECURSIVE_BENCH_DEPTH_LIMIT) {
+        printf("trees match: %s\n", memcmp(recursiveArray, iterativeArray, TREE_SIZE) == 0 ? "yes" : "no");
+    }
+
+    position = 0;
+    maxUsedIndex = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    parsed = parseAndBuildTreeIterative(input, &index, &position, &sparseTree, &maxUsedIndex) && parsed;
+    printf("sparse: %zu nodes, max index %lld, %zu bytes (array: %d bytes, %lld subtrees dropped), %.6f s\n",
+           sparseTree.count, maxUsedIndex, treeStoreBytes(&sparseTree), TREE_SIZE,
+           iterativeTree.droppedNodes, elapsedSeconds(&start));
+    if (sparseTree.droppedNodes > 0) {
+        printf("sparse: %lld subtrees past the index limit dropped\n", sparseTree.droppedNodes);
+    }
+    if (sparseTree.failedNodes > 0 || !parsed) {
+        printf("sparse: out of memory, %lld nodes not stored\n", sparseTree.failedNodes);
+    }
+
+    bool sparseMatches = true;
+    for (long long i = 1; i < TREE_SIZE; ++i) {
+        if (treeStoreGet(&sparseTree, i) != iterativeArray[i]) sparseMatches = false;
+    }
+    printf("sparse matches array: %s\n", sparseMatches ? "yes" : "no");
+
+    freeTreeStore(&sparseTree);
+    sexpr_index_free(&index);
+    free(input);
+    return 0;
+}
+
+// 노드 nodeCount개짜리 완전 이진 트리(인덱스 1..nodeCount)를 배열 저장소에 만들고
+// 반복자로 전체 순회한 시간과 중간에 멈추는 질의(k번째 중위 노드, 첫 일치 라벨)의 시간을 비교
+int runIteratorBench(long long nodeCount) {
+    if (nodeCount < 1) nodeCount = 10000000;
+    char* array = (char*)malloc((size_t)nodeCount + 1);
+    if (array == NULL) {
+        printf("out of memory\n");
+        return 1;
+    }
+    TreeStore tree;
+    initArrayStore(&tree, array, nodeCount + 1);
+    for (long long i = 1; i <= nodeCount; ++i) treeStoreSet(&tree, i, (char)('a' + i % 26));
+    // 찾을 라벨은 중위 순회 중간쯤에 한 번만 둔다
+    long long target = findKthInOrder(&tree, nodeCount, nodeCount / 2);
+    treeStoreSet(&tree, target, 'Z');
+
+    static const char* const orderNames[] = {"pre-order", "in-order", "post-order"};
+    struct timespec start;
+    printf("complete tree: %lld nodes\n", nodeCount);
+    for (int order = ORDER_PRE; order <= ORDER_POST; ++order) {
+        TreeIterator it;
+        long long visited = 0;
+        long long checksum = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        initTreeIterator(&it, &tree, nodeCount, (TraversalOrder)order);
+        while (!treeIteratorDone(&it)) {
+            long long index = treeIteratorNext(&it);
+            if (index == 0) break;
+            visited++;
+            checksum += index;
+        }
+        printf("full %-10s: %lld nodes (checksum %lld), %.6f s\n", orderNames[order], visited, checksum, elapsedSeconds(&start));
+    }
+
+    // 세 순서를 한 번의 순회로 모두 만들 때와 비교
+    OrderBuffer orders[3];
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool walked = singleWalkTraversal(&tree, nodeCount, orders);
+    printf("single walk (all three): %s, %.6f s\n", walked ? "ok" : "out of memory", elapsedSeconds(&start));
+    for (int i = 0; i < 3; ++i) freeOrderBuffer(&orders[i]);
+
+    long long ks[] = {1, 10, 1000, nodeCount / 2};
+    for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); ++i) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        long long index = findKthInOrder(&tree, nodeCount, ks[i]);
+        printf("k-th in-order (k=%lld): index %lld, %.6f s\n", ks[i], index, elapsedSeconds(&start));
+    }
+    for (int order = ORDER_PRE; order <= ORDER_POST; ++order) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        long long index = findFirstLabel(&tree, nodeCount, (TraversalOrder)order, 'Z');
+        printf("first 'Z' %-10s: index %lld, %.6f s\n", orderNames[order], index, elapsedSeconds(&start));
+    }
 
-    if (scanf("%[^\n]", inputString) != 1) return 1;
-    for (int i = 0; i < TREE_SIZE; ++i) treeArray[i] = '\0';
-    parseAndBuildTree(inputString, &stringPosition, treeArray, 1, &maxUsedIndex);
+    free(array);
+    return 0;
+}
+
+// 힙 인덱스를 소문자 26진 단어로 (큰 트리에서도 라벨이 겹치지 않도록)
+static int heapIndexLabel(long long index, char label[]) {
+    char reversed[16];
+    int length = 0;
+    for (; index > 0; index /= 26) reversed[length++] = (char)('a' + index % 26);
+    for (int i = 0; i < length; ++i) label[i] = reversed[length - 1 - i];
+    return length;
+}
+
+// 완전 이진 트리(인덱스 1..nodeCount)의 order 순서 라벨 줄을 만든다
+static char* orderText(const TreeStore* tree, long long nodeCount, TraversalOrder order) {
+    char* text = (char*)malloc((size_t)nodeCount * 16 + 1);
+    if (text == NULL) return NULL;
+    size_t length = 0;
+    TreeIterator it;
+    initTreeIterator(&it, tree, nodeCount, order);
+    while (!treeIteratorDone(&it)) {
+        long long index = treeIteratorNext(&it);
+        if (index == 0) break;
+        length += (size_t)heapIndexLabel(index, text + length);
+        text[length++] = ' ';
+    }
+    text[length] = '\0';
+    return text;
+}
+
+// 노드 nodeCount개짜리 완전 이진 트리의 세 순서를 만든 뒤
+// 전위+중위, 후위+중위로 각각 트리를 다시 만들고 빠진 순서가 원래 것과 같은지 확인한다
+int runRebuildBench(long long nodeCount) {
+    if (nodeCount < 1 || nodeCount > 100000000) nodeCount = 10000000;
+    char* array = (char*)malloc((size_t)nodeCount + 1);
+    if (array == NULL) {
+        printf("out of memory\n");
+        return 1;
+    }
+    TreeStore tree;
+    initArrayStore(&tree, array, nodeCount + 1);
+    for (long long i = 1; i <= nodeCount; ++i) treeStoreSet(&tree, i, 'a');
+
+    static const char* const orderNames[] = {"pre-order", "in-order", "post-order"};
+    LabelStream streams[3];
+    memset(streams, 0, sizeof(streams));
+    bool ok = true;
+    for (int order = ORDER_PRE; ok && order <= ORDER_POST; ++order) {
+        char* text = orderText(&tree, nodeCount, (TraversalOrder)order);
+        ok = text != NULL && splitLabelStream(text, &streams[order]);
+    }
+    free(array);
+    if (!ok) {
+        printf("out of memory\n");
+        for (int i = 0; i < 3; ++i) freeLabelStream(&streams[i]);
+        return 1;
+    }
+    printf("complete tree: %lld nodes\n", nodeCount);
+
+    int* positions = (int*)malloc(sizeof(int) * ((size_t)nodeCount + 2));
+    int* ids = (int*)malloc(sizeof(int) * ((size_t)nodeCount + 1));
+    for (int given = ORDER_PRE; ok && given <= ORDER_POST; given += 2) {
+        int missing = ORDER_PRE + ORDER_POST - given;
+        LinkedTree linked = {NULL, 0, 0};
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool rebuilt = positions != NULL && ids != NULL &&
+                       rebuildLinkedTree(&streams[ORDER_IN], &streams[given], (TraversalOrder)given, &linked, positions) &&
+                       listLinkedTree(&linked, (TraversalOrder)missing, ids);
+        double seconds = elapsedSeconds(&start);
+
+        bool matches = rebuilt;
+        for (long long i = 0; matches && i < nodeCount; ++i) {
+            matches = strcmp(streams[ORDER_IN].labels[positions[ids[i]]], streams[missing].labels[i]) == 0;
+        }
+        printf("%s + in-order -> %s: %s, %.6f s\n", orderNames[given], orderNames[missing],
+               !rebuilt ? "failed" : matches ? "matches" : "MISMATCH", seconds);
+        freeLinkedTree(&linked);
+        ok = matches;
+    }
+
+    free(positions);
+    free(ids);
+    for (int i = 0; i < 3; ++i) freeLabelStream(&streams[i]);
+    return ok ? 0 : 1;
+}
+
+typedef enum {
+    TRAVERSAL_STACK,        // 명시적 스택 (기본)
+    TRAVERSAL_MORRIS,       // 파서가 만든 연결 트리에서 스레드를 이용한 Morris 순회 (저장소를 쓰지 않음)
+    TRAVERSAL_ITERATOR,     // TreeIterator로 한 노드씩 당겨 출력
+    TRAVERSAL_SINGLE        // 한 번의 순회로 세 순서를 버퍼에 모은 뒤 출력
+} TraversalMode;
+
+static void printWithIterator(const TreeStore* tree, long long maxIndex, TraversalOrder order) {
+    TreeIterator it;
+    initTreeIterator(&it, tree, maxIndex, order);
+    while (!treeIteratorDone(&it)) {
+        long long index = treeIteratorNext(&it);
+        if (index != 0) printf("%c ", treeStoreGet(tree, index));
+    }
+}
+
+// 입력을 연결 트리로 파싱해 Morris 순회로 세 순서를 출력한다 (TRAVERSAL_MORRIS).
+// indexLimit은 같은 입력을 저장소에 넣었을 때 버려지는 노드를 똑같이 버리기 위한 힙 인덱스 상한이다.
+// 메모리가 부족하면 stderr에 알리고 false
+bool printMorrisTraversals(const char* inputString, size_t length, long long indexLimit, long long* droppedNodes) {
+    SexprIndex index;
+    if (!sexpr_index_build(&index, inputString, length, sexpr_classify_simd)) {
+        fprintf(stderr, "out of memory\n");
+        return false;
+    }
+    LinkedTree linked;
+    size_t stringPosition = 0;
+    bool ok = parseAndBuildLinkedTree(inputString, &index, &stringPosition, indexLimit, &linked, droppedNodes);
+    sexpr_index_free(&index);
+    if (!ok) {
+        fprintf(stderr, "out of memory: the tree could not be stored\n");
+        freeLinkedTree(&linked);
+        return false;
+    }
 
     printf("pre-order: ");
-    iterativePreOrder(treeArray, maxUsedIndex);
+    morrisPreOrder(&linked);
     printf("\nin-order: ");
-    iterativeInOrder(treeArray, maxUsedIndex);
+    morrisInOrder(&linked);
     printf("\npost-order: ");
-    iterativePostOrder(treeArray, maxUsedIndex);
+    ok = morrisPostOrder(&linked);
+    if (!ok) {
+        fflush(stdout);
+        fprintf(stderr, "\nout of memory: traversal stopped\n");
+    }
+    freeLinkedTree(&linked);
+    return ok;
+}
 
-    return 0;
+// 메모리가 부족해 순회를 끝내지 못하면 false (TRAVERSAL_MORRIS는 printMorrisTraversals가 맡는다)
+bool printTraversals(const TreeStore* tree, long long maxIndex, TraversalMode mode) {
+    if (mode == TRAVERSAL_SINGLE) {
+        OrderBuffer orders[3];
+        bool walked = singleWalkTraversal(tree, maxIndex, orders);
+        if (!walked) {
+            printf("out of memory\n");
+        } else {
+            printf("pre-order: %s", orders[ORDER_PRE].data ? orders[ORDER_PRE].data : "");
+            printf("\nin-order: %s", orders[ORDER_IN].data ? orders[ORDER_IN].data : "");
+            printf("\npost-order: %s", orders[ORDER_POST].data ? orders[ORDER_POST].data : "");
+        }
+        for (int i = 0; i < 3; ++i) freeOrderBuffer(&orders[i]);
+        return walked;
+    }
+    if (mode == TRAVERSAL_ITERATOR) {
+        printf("pre-order: ");
+        printWithIterator(tree, maxIndex, ORDER_PRE);
+        printf("\nin-order: ");
+        printWithIterator(tree, maxIndex, ORDER_IN);
+        printf("\npost-order: ");
+        printWithIterator(tree, maxIndex, ORDER_POST);
+        return true;
+    }
+
+    // 스택을 키우지 못하면 그 순서는 중간에 끊기므로 나머지는 출력하지 않고 stderr에 알린다
+    printf("pre-order: ");
+    bool ok = iterativePreOrder(tree, maxIndex);
+    if (ok) {
+        printf("\nin-order: ");
+        ok = iterativeInOrder(tree, maxIndex);
+    }
+    if (ok) {
+        printf("\npost-order: ");
+        ok = iterativePostOrder(tree, maxIndex);
+    }
+    if (!ok) {
+        fflush(stdout);
+        fprintf(stderr, "\nout of memory: traversal stopped\n");
+    }
+    return ok;
+}
+
+// 희소 저장소 모드: 길이 제한 없이 한 줄을 읽고, 깊이 10을 넘는 트리도 그대로 순회한다
+int runSparse(TraversalMode mode) {
+    char* inputString = NULL;
+    size_t bufferSize = 0;
+    ssize_t length = getline(&inputString, &bufferSize, stdin);
+    if (length < 0) {
+        free(inputString);
+        return 1;
+    }
+    if (length > 0 && inputString[length - 1] == '\n') inputString[--length] = '\0';
+
+    if (mode == TRAVERSAL_MORRIS) {
+        long long droppedNodes = 0;
+        bool printed = printMorrisTraversals(inputString, (size_t)length, SPARSE_INDEX_LIMIT, &droppedNodes);
+        if (droppedNodes > 0) {
+            fprintf(stderr, "%lld subtrees deeper than the index limit were dropped\n", droppedNodes);
+        }
+        free(inputString);
+        return printed ? 0 : 1;
+    }
+
+    TreeStore tree;
+    SexprIndex index;
+    size_t stringPosition = 0;
+    long long maxUsedIndex = 0;
+
+    if (!initSparseStore(&tree)) {
+        fprintf(stderr, "out of memory\n");
+        free(inputString);
+        return 1;
+    }
+    if (!sexpr_index_build(&index, inputString, (size_t)length, sexpr_classify_simd)) {
+        fprintf(stderr, "out of memory\n");
+        freeTreeStore(&tree);
+        free(inputString);
+        return 1;
+    }
+    bool parsed = parseAndBuildTreeIterative(inputString, &index, &stringPosition, &tree, &maxUsedIndex);
+    sexpr_index_free(&index);
+    if (tree.droppedNodes > 0) {
+        fprintf(stderr, "%lld subtrees deeper than the index limit were dropped\n", tree.droppedNodes);
+    }
+    // 빠진 노드가 있는 트리의 순회는 틀린 답이므로 출력하지 않는다
+    if (!parsed || tree.failedNodes > 0) {
+        fprintf(stderr, "out of memory: the tree could not be stored\n");
+        freeTreeStore(&tree);
+        free(inputString);
+        return 1;
+    }
+
+    bool printed = printTraversals(&tree, maxUsedIndex, mode);
+
+    freeTreeStore(&tree);
+    free(inputString);
+    return printed ? 0 : 1;
+}
+
+// 복원 모드: "pre-order: ..." / "in-order: ..." / "post-order: ..." 줄 중 중위 순서와 나머지 하나를 읽어
+// 트리를 다시 만들고 세 순서를 모두 출력한다 (전위와 후위가 다 있으면 전위로 만든다)
+int runRebuild(void) {
+    static const char* const orderNames[] = {"pre-order", "in-order", "post-order"};
+    LabelStream streams[3];
+    bool present[3] = {false, false, false};
+    char* line = NULL;
+    size_t bufferSize = 0;
+    bool ok = true;
+
+    while (ok && getline(&line, &bufferSize, stdin) >= 0) {
+        int order = 0;
+        while (order < 3 && strncmp(line, orderNames[order], strlen(orderNames[order])) != 0) order++;
+        if (order == 3 || present[order]) continue;
+        ok = splitLabelStream(line, &streams[order]);
+        present[order] = true;
+        line = NULL;
+        bufferSize = 0;
+    }
+    free(line);
+
+    TraversalOrder given = present[ORDER_PRE] ? ORDER_PRE : ORDER_POST;
+    TraversalOrder missing = given == ORDER_PRE ? ORDER_POST : ORDER_PRE;
+    int count = present[ORDER_IN] ? streams[ORDER_IN].count : 0;
+    int* positions = (int*)malloc(sizeof(int) * ((size_t)count + 2));
+    int* ids = (int*)malloc(sizeof(int) * ((size_t)count + 1));
+    LinkedTree linked = {NULL, 0, 0};
+    ok = ok && present[ORDER_IN] && present[given] && positions != NULL && ids != NULL &&
+         rebuildLinkedTree(&streams[ORDER_IN], &streams[given], given, &linked, positions) &&
+         listLinkedTree(&linked, missing, ids);
+
+    if (ok) {
+        // 주어진 두 순서는 그대로, 빠진 순서는 다시 만든 트리에서 읽는다
+        for (int order = ORDER_PRE; order <= ORDER_POST; ++order) {
+            printf("%s: ", orderNames[order]);
+            for (int i = 0; i < count; ++i) {
+                printf("%s ", order == (int)missing ? streams[ORDER_IN].labels[positions[ids[i]]] : streams[order].labels[i]);
+            }
+            printf("\n");
+        }
+    } else {
+        printf("ERROR\n");
+    }
+
+    freeLinkedTree(&linked);
+    free(positions);
+    free(ids);
+    for (int i = 0; i < 3; ++i) {
+        if (present[i]) freeLabelStream(&streams[i]);
+    }
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "--bench-parse") == 0) {
+        return runParseBench(argv[2]);
+    }
+
+    // 노드 수를 생략하면 1000만 개
+    if (argc >= 2 && strcmp(argv[1], "--bench-iter") == 0) {
+        return runIteratorBench(argc >= 3 ? atoll(argv[2]) : 0);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--bench-rebuild") == 0) {
+        return runRebuildBench(argc >= 3 ? atoll(argv[2]) : 0);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--rebuild") == 0) {
+        return runRebuild();
+    }
+
+    // 옵션: --sparse (희소 저장소), --morris-copy (파서가 만든 연결 트리에서 Morris 순회), --iter (반복자로 출력),
+    //       --single-walk (한 번의 순회로 세 순서 출력)
+    bool sparse = false;
+    TraversalMode mode = TRAVERSAL_STACK;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--sparse") == 0) sparse = true;
+        else if (strcmp(argv[i], "--morris-copy") == 0) mode = TRAVERSAL_MORRIS;
+        else if (strcmp(argv[i], "--iter") == 0) mode = TRAVERSAL_ITERATOR;
+        else if (strcmp(argv[i], "--single-walk") == 0) mode = TRAVERSAL_SINGLE;
+    }
+    if (sparse) {
+        return runSparse(mode);
+    }
+
+    char inputString[TREE_SIZE];
+    char treeArray[TREE_SIZE];
+    TreeStore tree;
+    size_t stringPosition = 0;
+    long long maxUsedIndex = 0;
+    SexprIndex index;
+
+    if (scanf("%1023[^\n]", inputString) != 1) return 1;
+    if (mode == TRAVERSAL_MORRIS) {
+        long long droppedNodes = 0;
+        return printMorrisTraversals(inputString, strlen(inputString), TREE_SIZE, &droppedNodes) ? 0 : 1;
+    }
+    initArrayStore(&tree, treeArray, TREE_SIZE);
+    if (!sexpr_index_build(&index, inputString, strlen(inputString), sexpr_classify_simd)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    bool parsed = parseAndBuildTreeIterative(inputString, &index, &stringPosition, &tree, &maxUsedIndex);
+    sexpr_index_free(&index);
+    if (!parsed) {
+        fprintf(stderr, "out of memory: the tree could not be stored\n");
+        return 1;
+    }
+
+    return printTraversals(&tree, maxUsedIndex, mode) ? 0 : 1;
 }
 
 /*
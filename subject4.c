@@ -2,6 +2,14 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "eytzinger.h"
+
+#define DEFAULT_DATA_SIZE 100
+#define DEFAULT_MAX_VALUE 1000
+#define PRINT_LIMIT 100   // 이보다 많으면 앞부분만 출력
 
 typedef struct BstNode {
     int data;
@@ -13,6 +21,9 @@ BstNode* createNewNode(int data);
 BstNode* insertValue(BstNode* root, int data);
 int performLinearSearch(const int* array, int size, int key, int* comparison_count);
 BstNode* performBstSearch(BstNode* root, int key, int* comparison_count);
+bool sampleUniqueKeys(int* array, int size, int max_value);
+bool buildEytzinger(EytzingerArray* eytzinger, const int* array, int size);
+bool performEytzingerSearch(const EytzingerArray* eytzinger, int key, int* comparison_count);
 
 void releaseTreeMemory(BstNode* root) {
     if (root == NULL) return;
@@ -21,41 +32,135 @@ void releaseTreeMemory(BstNode* root) {
     free(root);
 }
 
-bool isDuplicate(const int* array, int size, int value) {
-    for (int i = 0; i < size; i++) {
-        if (array[i] == value) {
-            return true;
+static uint64_t random_state = 88172645463325252ULL;
+
+// xorshift64* (rand()는 RAND_MAX가 작을 수 있어 큰 범위를 고르게 뽑지 못함)
+static uint64_t nextRandom(void) {
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    return random_state * 2685821657736338717ULL;
+}
+
+// 0 이상 bound 미만의 난수
+static uint32_t randomBelow(uint64_t bound) {
+    return (uint32_t)(((nextRandom() >> 32) * bound) >> 32);
+}
+
+// 이미 뽑은 값을 기억하는 해시 집합 (오픈 어드레싱, 선형 탐사). 빈 칸은 -1
+typedef struct {
+    int* slots;
+    size_t mask;
+} KeySet;
+
+static size_t keySlot(const KeySet* set, int value) {
+    return (size_t)(((uint64_t)(uint32_t)value * 0x9E3779B97F4A7C15ULL) >> 20) & set->mask;
+}
+
+// value를 넣는다. 이미 있으면 false
+static bool keySetInsert(KeySet* set, int value) {
+    size_t slot = keySlot(set, value);
+    while (set->slots[slot] != -1) {
+        if (set->slots[slot] == value) return false;
+        slot = (slot + 1) & set->mask;
+    }
+    set->slots[slot] = value;
+    return true;
+}
+
+// 0~max_value에서 서로 다른 값 size개를 뽑아 무작위 순서로 array에 채운다.
+// Floyd 표본 추출: j = N-size .. N-1마다 0~j에서 하나를 뽑고, 이미 뽑혔으면 j를 대신 넣는다.
+// 후보마다 앞 전체와 비교하던 방식(O(n^2)) 대신 해시 집합으로 O(n)이며 재시도도 없다.
+// Floyd 방식은 뽑힌 순서가 고르지 않으므로 마지막에 섞는다 (BST 모양이 삽입 순서를 따르므로).
+bool sampleUniqueKeys(int* array, int size, int max_value) {
+    uint64_t range = (uint64_t)max_value + 1;
+    if (size < 0 || (uint64_t)size > range) return false;
+
+    size_t capacity = 16;
+    while (capacity < (size_t)size * 2) capacity *= 2;
+    KeySet set = {(int*)malloc(sizeof(int) * capacity), capacity - 1};
+    if (set.slots == NULL) return false;
+    for (size_t i = 0; i < capacity; i++) set.slots[i] = -1;
+
+    int count = 0;
+    for (uint64_t j = range - (uint64_t)size; j < range; j++) {
+        int candidate = (int)randomBelow(j + 1);
+        if (!keySetInsert(&set, candidate)) {
+            candidate = (int)j;
+            keySetInsert(&set, candidate);
         }
+        array[count++] = candidate;
     }
-    return false;
+    free(set.slots);
+
+    // Fisher-Yates
+    for (int i = size - 1; i > 0; i--) {
+        int j = (int)randomBelow((uint64_t)i + 1);
+        int temp = array[i];
+        array[i] = array[j];
+        array[j] = temp;
+    }
+    return true;
 }
 
-int main() {
-    srand((unsigned int)time(NULL));
+// 사용법: subject4 [데이터 개수 [최댓값]] (기본 100개, 0-1000)
+int main(int argc, char* argv[]) {
+    random_state ^= (uint64_t)time(NULL) * 0x9E3779B97F4A7C15ULL;
 
-    const int DATA_SIZE = 100;
-    const int MAX_VALUE = 1000;
+    long long requested_size = argc > 1 ? atoll(argv[1]) : DEFAULT_DATA_SIZE;
+    long long requested_max = argc > 2 ? atoll(argv[2]) : DEFAULT_MAX_VALUE;
+    if (requested_size < 1 || requested_size > INT32_MAX || requested_max < 0 || requested_max > INT32_MAX - 1 ||
+        requested_size > requested_max + 1) {
+        printf(">> 잘못된 크기입니다: 데이터 개수는 1 이상, 최댓값 + 1 이하여야 합니다.\n");
+        return 1;
+    }
+    const int DATA_SIZE = (int)requested_size;
+    const int MAX_VALUE = (int)requested_max;
 
-    int data_array[DATA_SIZE];
+    int* data_array = (int*)malloc(sizeof(int) * (size_t)DATA_SIZE);
     BstNode* root_node = NULL;
+    EytzingerArray eytzinger;
+    if (data_array == NULL) {
+        printf(">> 메모리가 부족합니다.\n");
+        return 1;
+    }
 
     printf("\n* * * 탐색 알고리즘 성능 비교 * * *\n");
     printf(">> %d개의 고유한 난수(0-%d)를 생성합니다.\n\n", DATA_SIZE, MAX_VALUE);
 
-    // 1. 중복되지 않는 100개의 난수를 배열과 이진 탐색 트리에 추가
-    for (int i = 0; i < DATA_SIZE; ) {
-        int random_val = rand() % (MAX_VALUE + 1);
-        if (!isDuplicate(data_array, i, random_val)) {
-            data_array[i] = random_val;
-            root_node = insertValue(root_node, random_val);
+    // 1. 중복되지 않는 난수를 배열과 이진 탐색 트리에 추가
+    clock_t start_time_build = clock();
+    if (!sampleUniqueKeys(data_array, DATA_SIZE, MAX_VALUE)) {
+        printf(">> 메모리가 부족합니다.\n");
+        free(data_array);
+        return 1;
+    }
+    double elapsed_time_sample = (double)(clock() - start_time_build) / CLOCKS_PER_SEC;
+    for (int i = 0; i < DATA_SIZE; i++) {
+        root_node = insertValue(root_node, data_array[i]);
+        if (i < PRINT_LIMIT) {
             printf("%4d ", data_array[i]);
             if ((i + 1) % 10 == 0) {
                 printf("\n");
             }
-            i++;
         }
     }
     printf("\n");
+    double elapsed_time_tree = (double)(clock() - start_time_build) / CLOCKS_PER_SEC - elapsed_time_sample;
+
+    // 정렬한 키를 Eytzinger(BFS) 순서로 담은 정적 탐색 배열
+    clock_t start_time_eytzinger = clock();
+    if (!buildEytzinger(&eytzinger, data_array, DATA_SIZE)) {
+        printf(">> 메모리가 부족합니다.\n");
+        releaseTreeMemory(root_node);
+        free(data_array);
+        return 1;
+    }
+    double elapsed_time_layout = (double)(clock() - start_time_eytzinger) / CLOCKS_PER_SEC;
+    if (DATA_SIZE > PRINT_LIMIT) {
+        printf(">> (앞 %d개만 표시) 난수 생성 %.3f초, 트리 구축 %.3f초, Eytzinger 배열 구축 %.3f초\n\n", PRINT_LIMIT,
+               elapsed_time_sample, elapsed_time_tree, elapsed_time_layout);
+    }
 
     // 2. 사용자로부터 값을 입력받아 탐색 실행
     while (true) {
@@ -84,6 +189,12 @@ int main() {
         BstNode* result_node = performBstSearch(root_node, search_key, &bst_comparisons);
         double elapsed_time_bst = (double)(clock() - start_time_bst) / CLOCKS_PER_SEC;
 
+        // [C] 분기 없는 탐색 (Eytzinger 배열)
+        int eytzinger_comparisons = 0;
+        clock_t start_time_eytzinger_search = clock();
+        performEytzingerSearch(&eytzinger, search_key, &eytzinger_comparisons);
+        double elapsed_time_eytzinger = (double)(clock() - start_time_eytzinger_search) / CLOCKS_PER_SEC;
+
         // --- ✨ UI가 수정된 출력 부분 ✨ ---
         printf("\n--- [ %d ] 탐색 결과 ---\n", search_key);
         printf("결과: %s\n", (result_index != -1) ? " 발견" : " 없음");
@@ -92,10 +203,13 @@ int main() {
         printf("+------------------+---------------+-----------------+\n");
         printf("| 선형 탐색          | %-13d | %-15.8f |\n", linear_comparisons, elapsed_time_linear);
         printf("| 이진 탐색 트리      | %-13d | %-15.8f |\n", bst_comparisons, elapsed_time_bst);
+        printf("| Eytzinger 배열     | %-13d | %-15.8f |\n", eytzinger_comparisons, elapsed_time_eytzinger);
         printf("+------------------+---------------+-----------------+\n\n");
     }
 
     releaseTreeMemory(root_node);
+    eytzinger_free(&eytzinger);
+    free(data_array);
 
     return 0;
 }
@@ -133,6 +247,30 @@ BstNode* performBstSearch(BstNode* root, int key, int* comparison_count) {
     return NULL;
 }
 
+static int compareKeys(const void* a, const void* b) {
+    int left = *(const int*)a;
+    int right = *(const int*)b;
+    return (left > right) - (left < right);
+}
+
+bool buildEytzinger(EytzingerArray* eytzinger, const int* array, int size) {
+    int* sorted = (int*)malloc(sizeof(int) * (size_t)size);
+    if (sorted == NULL) return false;
+    memcpy(sorted, array, sizeof(int) * (size_t)size);
+    qsort(sorted, (size_t)size, sizeof(int), compareKeys);
+    bool built = eytzinger_build(eytzinger, sorted, (size_t)size);
+    free(sorted);
+    return built;
+}
+
+// 내려가며 비교한 키 수 + 마지막 일치 확인 1회
+bool performEytzingerSearch(const EytzingerArray* eytzinger, int key, int* comparison_count) {
+    size_t position = eytzinger_lower_bound(eytzinger, key, comparison_count);
+    if (position == 0) return false;
+    (*comparison_count)++;
+    return eytzinger->keys[position] == key;
+}
+
 int performLinearSearch(const int* array, int size, int key, int* comparison_count) {
     *comparison_count = 0;
     for (int i = 0; i < size; i++) {
@@ -1,12 +1,32 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+// B+트리(6번)의 노드 안 비교는 기본 빌드에서 SSE2를 쓴다. AVX2 경로는 -mavx2로 빌드해야 켜진다
+// (예: gcc -O2 -mavx2 subject5.c). 둘 다 없는 환경에서는 스칼라 반복문으로 비교한다.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "eytzinger.h"
+#include "perf_counter.h"
+
 // ========== 1. 상수 및 전역 변수 정의 ==========
 
 #define SIZE 1000     // 데이터 개수
 #define MAX_VAL 10001 // 난수 범위 (0 ~ 10000)
 
+// 규모별 벤치마크 (--bench) 설정
+#define BENCH_QUERY_COUNT 1000000       // 구조마다 탐색 횟수
+#define BENCH_LINEAR_WORK 200000000LL   // 선형 탐색은 (키 수 x 탐색 횟수)가 이 정도가 되도록 줄임
+#define BENCH_TREE_LIMIT 10000000       // 이보다 크면 노드 트리(BST/AVL)는 메모리 때문에 생략
+#define BENCH_RANGE_WIDTH 400             // 범위 탐색 구간 폭 (키 약 100개)
+#define SEARCH_GROUP_MAX 64               // 묶음 탐색에서 동시에 진행하는 탐색 수 상한
+
 // 탐색 횟수를 기록하기 위한 전역 변수
 // (함수 파라미터로 넘기는 것보다 구현이 간편하여 사용)
 long long g_comparison_count = 0;
@@ -154,11 +174,166 @@ Node* bst_insert(Node* node, int key) {
     return node;
 }
 
-// ========== 6. 탐색 함수 (비교 횟수 카운트) ==========
+// ========== 6. B+트리 함수 ==========
+
+// 노드마다 키 16개(64바이트 캐시 라인 하나)를 두고, 노드 안에서는 16개를 한꺼번에 비교한다.
+// 빈 칸은 INT_MAX로 채워 두므로 (INT_MAX는 키로 쓸 수 없음) 노드 안 탐색에 분기가 없다.
+// 정렬된 키로 한 번에 만드는 정적 트리: 모든 노드를 한 배열에 층별로(루트 먼저) 이어 놓고,
+// 층 안 j번째 내부 노드의 자식은 다음 층의 17j ~ 17j+16번째 노드다. 자식 포인터가 없으므로
+// 노드는 키 16개뿐이고 한 층을 내려갈 때 읽는 캐시 라인은 하나다.
+// 리프는 앞에서부터 16개씩 꽉 채우므로 (마지막 리프만 덜 참) 범위 탐색은 다음 리프로 그냥 넘어간다.
+#define BPLUS_KEYS 16
+#define BPLUS_FANOUT (BPLUS_KEYS + 1)
+#define BPLUS_MAX_HEIGHT 32
+
+typedef struct {
+    int keys[BPLUS_KEYS];               // 내부 노드: keys[i] = (i + 1)번째 자식 서브트리의 최솟값
+} __attribute__((aligned(64))) BPlusNode;
+
+typedef struct {
+    BPlusNode* nodes;
+    size_t level_start[BPLUS_MAX_HEIGHT + 1];   // 층별 첫 노드 번호 (0 = 루트, height = 리프 층)
+    int height;         // 루트에서 리프까지 내부 노드 수
+    long long count;    // 키 수
+    long long leaves;
+    long long total;    // 노드 수
+} BPlusTree;
+
+// 노드의 키 16개 중 key보다 큰 키 수 (빈 칸 포함)
+static inline int bplus_count_greater(const int keys[], int key) {
+#if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi32(key);
+    __m256i low = _mm256_cmpgt_epi32(_mm256_load_si256((const __m256i*)keys), needle);
+    __m256i high = _mm256_cmpgt_epi32(_mm256_load_si256((const __m256i*)(keys + 8)), needle);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(low)) | (_mm256_movemask_ps(_mm256_castsi256_ps(high)) << 8);
+    return __builtin_popcount((unsigned)mask);
+#elif defined(__SSE2__)
+    // 비교 결과 네 개를 8비트로 줄여 movemask 한 번으로 센다
+    __m128i needle = _mm_set1_epi32(key);
+    __m128i a = _mm_cmpgt_epi32(_mm_load_si128((const __m128i*)keys), needle);
+    __m128i b = _mm_cmpgt_epi32(_mm_load_si128((const __m128i*)(keys + 4)), needle);
+    __m128i c = _mm_cmpgt_epi32(_mm_load_si128((const __m128i*)(keys + 8)), needle);
+    __m128i d = _mm_cmpgt_epi32(_mm_load_si128((const __m128i*)(keys + 12)), needle);
+    __m128i packed = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+    return __builtin_popcount((unsigned)_mm_movemask_epi8(packed));
+#else
+    int count = 0;
+    for (int i = 0; i < BPLUS_KEYS; i++) count += keys[i] > key;
+    return count;
+#endif
+}
+
+// 노드의 키 16개 중 key보다 작은 키 수 (빈 칸은 INT_MAX라 세지 않음)
+static inline int bplus_count_less(const int keys[], int key) {
+    return key == INT_MIN ? 0 : BPLUS_KEYS - bplus_count_greater(keys, key - 1);
+}
+
+// 내부 노드에서 key가 들어 있을 자식 번호 (= key 이하인 키 수)
+static inline int bplus_child_index(const BPlusNode* inner, int key) {
+    return BPLUS_KEYS - bplus_count_greater(inner->keys, key);
+}
+
+void bplus_init(BPlusTree* tree) {
+    memset(tree, 0, sizeof(*tree));
+}
+
+// 오름차순 키 count개(중복 없음, INT_MAX 제외)로 트리를 만든다. 메모리 부족 시 0
+int bplus_build(BPlusTree* tree, const int sorted[], long long count) {
+    bplus_init(tree);
+    if (count <= 0) return 1;
+
+    // 1. 층별 노드 수: 리프 ceil(count / 16)개, 위로 갈수록 17개씩 묶는다
+    long long level_nodes[BPLUS_MAX_HEIGHT + 1];
+    int levels = 0;
+    level_nodes[0] = (count + BPLUS_KEYS - 1) / BPLUS_KEYS;
+    while (level_nodes[levels] > 1) {
+        if (levels + 1 > BPLUS_MAX_HEIGHT) return 0;
+        level_nodes[levels + 1] = (level_nodes[levels] + BPLUS_FANOUT - 1) / BPLUS_FANOUT;
+        levels++;
+    }
+    tree->height = levels;
+    long long total = 0;
+    for (int depth = 0; depth <= levels; depth++) {
+        tree->level_start[depth] = (size_t)total;
+        total += level_nodes[levels - depth];
+    }
+
+    BPlusNode* nodes = (BPlusNode*)aligned_alloc(64, sizeof(BPlusNode) * (size_t)total);
+    int* mins = (int*)malloc(sizeof(int) * (size_t)level_nodes[0]);   // 아래 층 노드별 서브트리 최솟값
+    if (nodes == NULL || mins == NULL) {
+        free(nodes);
+        free(mins);
+        return 0;
+    }
+
+    // 2. 리프를 앞에서부터 채운다
+    BPlusNode* leaves = nodes + tree->level_start[levels];
+    for (long long j = 0; j < level_nodes[0]; j++) {
+        for (int i = 0; i < BPLUS_KEYS; i++) {
+            long long k = j * BPLUS_KEYS + i;
+            leaves[j].keys[i] = k < count ? sorted[k] : INT_MAX;
+        }
+        mins[j] = leaves[j].keys[0];
+    }
+
+    // 3. 아래 층의 최솟값으로 위 층 노드의 키를 채우고, 위 층 최솟값은 첫 자식의 최솟값
+    for (int depth = levels - 1; depth >= 0; depth--) {
+        BPlusNode* level = nodes + tree->level_start[depth];
+        long long below = level_nodes[levels - depth - 1];
+        for (long long j = 0; j < level_nodes[levels - depth]; j++) {
+            for (int i = 0; i < BPLUS_KEYS; i++) {
+                long long child = j * BPLUS_FANOUT + i + 1;
+                level[j].keys[i] = child < below ? mins[child] : INT_MAX;
+            }
+            mins[j] = mins[j * BPLUS_FANOUT];   // j * 17 >= j이므로 덮어쓰기 전에 읽는다
+        }
+    }
+    free(mins);
+
+    tree->nodes = nodes;
+    tree->count = count;
+    tree->leaves = level_nodes[0];
+    tree->total = total;
+    return 1;
+}
+
+// key가 들어 있을 리프의 번호 (비교 횟수는 노드 방문 수, 노드마다 SIMD 비교 한 번).
+// 자식 위치는 계산으로 정해지므로 노드에서 읽는 것은 키 한 줄뿐이다.
+long long bplus_find_leaf(const BPlusTree* tree, int key) {
+    size_t index = 0;
+    for (int depth = 0; depth < tree->height; depth++) {
+        g_comparison_count++;
+        const BPlusNode* inner = &tree->nodes[tree->level_start[depth] + index];
+        index = index * BPLUS_FANOUT + (size_t)bplus_child_index(inner, key);
+    }
+    return (long long)index;
+}
+
+// [low, high] 구간의 키 수: 시작 리프를 찾은 뒤 이어지는 리프를 차례로 센다
+long long bplus_range_count(const BPlusTree* tree, int low, int high) {
+    if (tree->count == 0 || low > high || low == INT_MAX) return 0;
+    if (high == INT_MAX) high = INT_MAX - 1;
+    const BPlusNode* leaves = tree->nodes + tree->level_start[tree->height];
+    long long leaf = bplus_find_leaf(tree, low);
+    long long count = -bplus_count_less(leaves[leaf].keys, low);
+    for (; leaf < tree->leaves; leaf++) {
+        int within = BPLUS_KEYS - bplus_count_greater(leaves[leaf].keys, high);
+        count += within;
+        if (within < BPLUS_KEYS) break;
+    }
+    return count;
+}
+
+void bplus_free(BPlusTree* tree) {
+    free(tree->nodes);
+    bplus_init(tree);
+}
+
+// ========== 7. 탐색 함수 (비교 횟수 카운트) ==========
 
 // (1) 배열: 선형 탐색
-void linear_search(int arr[], int key) {
-    for (int i = 0; i < SIZE; i++) {
+void linear_search(int arr[], int size, int key) {
+    for (int i = 0; i < size; i++) {
         g_comparison_count++; // 비교 횟수 증가
         if (arr[i] == key) {
             return; // 찾음
@@ -184,7 +359,106 @@ void tree_search(Node* root, int key) {
     }
 }
 
-// ========== 7. 데이터 생성 함수 ==========
+// (2-1) BST & AVL: 묶음 탐색
+// keys를 group개씩 동시에 진행한다. 차례마다 각 탐색을 한 단계씩 내려보내며
+// 다음 노드를 __builtin_prefetch로 불러 두고 다른 탐색으로 넘어가므로, 한 탐색이 캐시 미스를
+// 기다리는 동안 나머지 탐색의 미스도 함께 진행된다. 끝난 자리는 바로 다음 키로 채운다.
+// 비교 횟수는 키마다 tree_search를 부른 것과 같고, found가 NULL이 아니면 found[i]에 찾았는지(1/0) 기록
+void tree_search_batch(Node* root, const int keys[], int count, int group, int found[]) {
+    Node* cursor[SEARCH_GROUP_MAX];
+    int slot_key[SEARCH_GROUP_MAX];  // 자리마다 진행 중인 키 번호 (-1 = 빈 자리)
+    if (group < 1) group = 1;
+    if (group > SEARCH_GROUP_MAX) group = SEARCH_GROUP_MAX;
+
+    int next = 0;
+    int active = 0;
+    for (int g = 0; g < group; g++) {
+        slot_key[g] = next < count ? next++ : -1;
+        cursor[g] = root;
+        if (slot_key[g] >= 0) active++;
+    }
+
+    while (active > 0) {
+        for (int g = 0; g < group; g++) {
+            int index = slot_key[g];
+            if (index < 0) continue;
+
+            Node* node = cursor[g];
+            if (node != NULL) {
+                g_comparison_count++; // 현재 노드와 비교 횟수 증가
+                if (node->key != keys[index]) {
+                    node = (keys[index] < node->key) ? node->left : node->right;
+                    __builtin_prefetch(node);
+                    cursor[g] = node;
+                    continue;
+                }
+            }
+
+            // 탐색 종료 (node == NULL이면 못 찾음): 이 자리에 다음 키를 넣는다
+            if (found != NULL) found[index] = node != NULL;
+            slot_key[g] = next < count ? next++ : -1;
+            cursor[g] = root;
+            if (slot_key[g] < 0) active--;
+        }
+    }
+}
+
+// (3) Eytzinger 배열: 정렬된 키를 BFS 순서로 둔 정적 배열에서 분기 없이 탐색
+// 비교 횟수 = 내려가며 비교한 키 수 + 마지막 일치 확인 1회
+void eytzinger_search(const EytzingerArray* eytzinger, int key) {
+    int levels;
+    size_t position = eytzinger_lower_bound(eytzinger, key, &levels);
+    g_comparison_count += levels + (position != 0);
+}
+
+// (4) B+트리: 노드마다 키 16개를 한 번에 비교 (비교 횟수 = 방문한 노드 수)
+int bplus_search(const BPlusTree* tree, int key) {
+    if (tree->count == 0 || key == INT_MAX) return 0;
+    const BPlusNode* leaf = &tree->nodes[tree->level_start[tree->height] + (size_t)bplus_find_leaf(tree, key)];
+    g_comparison_count++;
+    int position = bplus_count_less(leaf->keys, key);
+    return position < BPLUS_KEYS && leaf->keys[position] == key;
+}
+
+int compare_keys(const void* a, const void* b) {
+    int left = *(const int*)a;
+    int right = *(const int*)b;
+    return (left > right) - (left < right);
+}
+
+// data를 정렬한 복사본 (메모리 부족 시 NULL)
+int* sorted_copy(const int data[], int size) {
+    int* sorted = (int*)malloc(sizeof(int) * (size_t)(size > 0 ? size : 1));
+    if (sorted == NULL) return NULL;
+    memcpy(sorted, data, sizeof(int) * (size_t)size);
+    qsort(sorted, (size_t)size, sizeof(int), compare_keys);
+    return sorted;
+}
+
+// data를 정렬한 복사본으로 Eytzinger 배열 구축 (메모리 부족 시 0)
+int build_eytzinger(EytzingerArray* eytzinger, const int data[], int size) {
+    int* sorted = sorted_copy(data, size);
+    if (sorted == NULL) return 0;
+    int built = eytzinger_build(eytzinger, sorted, (size_t)size);
+    free(sorted);
+    return built;
+}
+
+// data를 정렬해 B+트리 구축. 중복 키는 하나만 넣는다 (AVL/BST와 같음). 메모리 부족 시 0
+int build_bplus(BPlusTree* bplus, const int data[], int size) {
+    bplus_init(bplus);
+    int* sorted = sorted_copy(data, size);
+    if (sorted == NULL) return 0;
+    int unique = 0;
+    for (int i = 0; i < size; i++) {
+        if (unique == 0 || sorted[i] != sorted[unique - 1]) sorted[unique++] = sorted[i];
+    }
+    int built = bplus_build(bplus, sorted, unique);
+    free(sorted);
+    return built;
+}
+
+// ========== 8. 데이터 생성 함수 ==========
 
 // 데이터 (1): 0~10000 사이의 무작위 정수 1000개 (중복 X)
 void create_dataset_1(int arr[]) {
@@ -232,7 +506,7 @@ void create_search_keys(int keys[]) {
     }
 }
 
-// ========== 8. 메모리 해제 함수 ==========
+// ========== 9. 메모리 해제 함수 ==========
 
 // 트리에 할당된 메모리 해제 (후위 순회 방식)
 void free_tree(Node* node) {
@@ -242,13 +516,15 @@ void free_tree(Node* node) {
     free(node);
 }
 
-// ========== 9. 실험 진행 및 출력 함수 ==========
+// ========== 10. 실험 진행 및 출력 함수 ==========
 
 void run_experiment(int data[], int search_keys[], int dataset_num) {
     // 1. 자료구조 선언 및 구축
     int array_data[SIZE];
     Node* bst_root = NULL;
     Node* avl_root = NULL;
+    EytzingerArray eytzinger;
+    BPlusTree bplus;
 
     for (int i = 0; i < SIZE; i++) {
         // (1) 배열 삽입
@@ -260,11 +536,27 @@ void run_experiment(int data[], int search_keys[], int dataset_num) {
         // (3) AVL 삽입
         avl_root = avl_insert(avl_root, data[i]);
     }
+    // (4) B+트리, (5) Eytzinger 배열 구축 (정렬 후 한 번에)
+    if (!build_bplus(&bplus, data, SIZE)) {
+        printf("메모리 부족\n");
+        free_tree(bst_root);
+        free_tree(avl_root);
+        return;
+    }
+    if (!build_eytzinger(&eytzinger, data, SIZE)) {
+        printf("메모리 부족\n");
+        free_tree(bst_root);
+        free_tree(avl_root);
+        bplus_free(&bplus);
+        return;
+    }
 
     // 2. 총 탐색 횟수 기록용 변수
     long long array_total_comps = 0;
     long long bst_total_comps = 0;
     long long avl_total_comps = 0;
+    long long bplus_total_comps = 0;
+    long long eytzinger_total_comps = 0;
 
     // 3. 1000개의 탐색 키로 각각 탐색 수행
     for (int i = 0; i < SIZE; i++) {
@@ -272,7 +564,7 @@ void run_experiment(int data[], int search_keys[], int dataset_num) {
 
         // (1) 배열 탐색
         g_comparison_count = 0; // 탐색 전 횟수 초기화
-        linear_search(array_data, key_to_find);
+        linear_search(array_data, SIZE, key_to_find);
         array_total_comps += g_comparison_count;
 
         // (2) BST 탐색
@@ -284,6 +576,16 @@ void run_experiment(int data[], int search_keys[], int dataset_num) {
         g_comparison_count = 0; // 탐색 전 횟수 초기화
         tree_search(avl_root, key_to_find);
         avl_total_comps += g_comparison_count;
+
+        // (4) B+트리 탐색
+        g_comparison_count = 0; // 탐색 전 횟수 초기화
+        bplus_search(&bplus, key_to_find);
+        bplus_total_comps += g_comparison_count;
+
+        // (5) Eytzinger 배열 탐색
+        g_comparison_count = 0; // 탐색 전 횟수 초기화
+        eytzinger_search(&eytzinger, key_to_find);
+        eytzinger_total_comps += g_comparison_count;
     }
 
     // 4. 결과 출력
@@ -291,19 +593,235 @@ void run_experiment(int data[], int search_keys[], int dataset_num) {
     printf("Array: 데이터 (%d)에서 평균 %.2f회 탐색\n", dataset_num, (double)array_total_comps / SIZE);
     printf("BST:   데이터 (%d)에서 평균 %.2f회 탐색\n", dataset_num, (double)bst_total_comps / SIZE);
     printf("AVL:   데이터 (%d)에서 평균 %.2f회 탐색\n", dataset_num, (double)avl_total_comps / SIZE);
+    printf("B+T:   데이터 (%d)에서 평균 %.2f회 탐색 (노드 방문, 노드마다 키 16개 동시 비교)\n", dataset_num,
+           (double)bplus_total_comps / SIZE);
+    printf("Eytz:  데이터 (%d)에서 평균 %.2f회 탐색\n", dataset_num, (double)eytzinger_total_comps / SIZE);
     printf("\n");
 
     // 5. 메모리 해제
     free_tree(bst_root);
     free_tree(avl_root);
+    bplus_free(&bplus);
+    eytzinger_free(&eytzinger);
+}
+
+// ========== 11. 규모별 탐색 벤치마크 ==========
+
+// 탐색 한 종류의 측정 결과
+typedef struct {
+    long long comparisons;
+    long long lookups;
+    double seconds;
+    long long cache_misses; // -1 = 측정 불가
+} SearchStats;
+
+double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// kind: 0 = 배열 선형 탐색, 1 = 트리 탐색, 2 = Eytzinger 배열, 3 = B+트리, 4 = B+트리 범위 탐색
+// (범위 탐색은 [키, 키 + BENCH_RANGE_WIDTH] 구간의 키 수를 센다)
+SearchStats measure_search(int kind, int array[], int size, Node* root, const EytzingerArray* eytzinger,
+                           const BPlusTree* bplus, const int queries[], long long lookups, PerfCounter* counter) {
+    SearchStats stats;
+    struct timespec start;
+    g_comparison_count = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    perf_counter_start(counter);
+    for (long long i = 0; i < lookups; i++) {
+        if (kind == 0) linear_search(array, size, queries[i]);
+        else if (kind == 1) tree_search(root, queries[i]);
+        else if (kind == 2) eytzinger_search(eytzinger, queries[i]);
+        else if (kind == 3) bplus_search(bplus, queries[i]);
+        else bplus_range_count(bplus, queries[i], queries[i] + BENCH_RANGE_WIDTH);
+    }
+    stats.cache_misses = perf_counter_stop(counter);
+    stats.seconds = elapsed_seconds(&start);
+    stats.comparisons = g_comparison_count;
+    stats.lookups = lookups;
+    return stats;
+}
+
+void print_search_stats(const char* name, SearchStats stats) {
+    printf("%-10s %12.2f %12.1f", name, (double)stats.comparisons / stats.lookups, stats.seconds * 1e9 / stats.lookups);
+    if (stats.cache_misses < 0) printf(" %14s\n", "n/a");
+    else printf(" %14.2f\n", (double)stats.cache_misses / stats.lookups);
 }
 
-// ========== 10. 메인 함수 ==========
+// rand()를 두 번 써서 RAND_MAX보다 큰 범위의 난수
+int bench_random_below(long long bound) {
+    return (int)(((long long)rand() * RAND_MAX + rand()) % bound);
+}
 
-int main() {
+// 구간 [4i, 4i+4)마다 하나씩 뽑으면 중복 없이 정렬된 키가 된다. 탐색 키는 0 ~ 4*size 범위
+void create_bench_keys(int data[], int size, int queries[]) {
+    for (int i = 0; i < size; i++) data[i] = 4 * i + rand() % 4;
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) queries[i] = bench_random_below(4LL * size);
+}
+
+// 트리 삽입 순서용으로 섞기 (Fisher-Yates)
+void shuffle_keys(int data[], int size) {
+    for (int i = size - 1; i > 0; i--) swap(&data[i], &data[bench_random_below(i + 1)]);
+}
+
+// 키 size개 (0 ~ 4*size 범위의 서로 다른 난수)로 네 구조를 만들고 같은 무작위 키로 탐색
+int run_search_bench(int size, PerfCounter* counter) {
+    int* data = (int*)malloc(sizeof(int) * (size_t)size);
+    int* queries = (int*)malloc(sizeof(int) * BENCH_QUERY_COUNT);
+    EytzingerArray eytzinger;
+    if (data == NULL || queries == NULL) {
+        printf("메모리 부족\n");
+        free(data);
+        free(queries);
+        return 1;
+    }
+    create_bench_keys(data, size, queries);
+    if (!build_eytzinger(&eytzinger, data, size)) {
+        printf("메모리 부족\n");
+        free(data);
+        free(queries);
+        return 1;
+    }
+    shuffle_keys(data, size);
+
+    long long linear_lookups = BENCH_LINEAR_WORK / size;
+    if (linear_lookups < 1) linear_lookups = 1;
+    if (linear_lookups > BENCH_QUERY_COUNT) linear_lookups = BENCH_QUERY_COUNT;
+
+    printf("--- [키 %d개, 탐색 %d회] ---\n", size, BENCH_QUERY_COUNT);
+    printf("구조           평균 비교      ns/탐색 캐시 미스/탐색\n");
+    print_search_stats("Array", measure_search(0, data, size, NULL, NULL, NULL, queries, linear_lookups, counter));
+
+    if (size <= BENCH_TREE_LIMIT) {
+        Node* bst_root = NULL;
+        Node* avl_root = NULL;
+        for (int i = 0; i < size; i++) {
+            bst_root = bst_insert(bst_root, data[i]);
+            avl_root = avl_insert(avl_root, data[i]);
+        }
+        print_search_stats("BST", measure_search(1, NULL, 0, bst_root, NULL, NULL, queries, BENCH_QUERY_COUNT, counter));
+        print_search_stats("AVL", measure_search(1, NULL, 0, avl_root, NULL, NULL, queries, BENCH_QUERY_COUNT, counter));
+        free_tree(bst_root);
+        free_tree(avl_root);
+    } else {
+        printf("BST/AVL    (키가 %d개를 넘어 생략)\n", BENCH_TREE_LIMIT);
+    }
+    print_search_stats("Eytzinger", measure_search(2, NULL, 0, NULL, &eytzinger, NULL, queries, BENCH_QUERY_COUNT, counter));
+
+    BPlusTree bplus;
+    if (build_bplus(&bplus, data, size)) {
+        print_search_stats("B+tree", measure_search(3, NULL, 0, NULL, NULL, &bplus, queries, BENCH_QUERY_COUNT, counter));
+        print_search_stats("B+ range", measure_search(4, NULL, 0, NULL, NULL, &bplus, queries, BENCH_QUERY_COUNT / 10, counter));
+        printf("(B+tree: 노드 %lld개, 높이 %d, 비교 = 방문한 노드 수 / B+ range: 폭 %d 구간의 키를 이어진 리프에서 셈)\n",
+               bplus.total, bplus.height + 1, BENCH_RANGE_WIDTH);
+    } else {
+        printf("B+tree     (메모리 부족)\n");
+    }
+    printf("\n");
+
+    bplus_free(&bplus);
+    eytzinger_free(&eytzinger);
+    free(data);
+    free(queries);
+    return 0;
+}
+
+// 키 size개짜리 BST와 AVL에서 같은 탐색 키를 하나씩(tree_search) 찾을 때와
+// 묶음으로(tree_search_batch) 찾을 때의 처리량 비교
+int run_batch_bench(int size) {
+    static const int groups[] = {4, 8, 16, 32};
+    int* data = (int*)malloc(sizeof(int) * (size_t)size);
+    int* queries = (int*)malloc(sizeof(int) * BENCH_QUERY_COUNT);
+    if (data == NULL || queries == NULL) {
+        printf("메모리 부족\n");
+        free(data);
+        free(queries);
+        return 1;
+    }
+    create_bench_keys(data, size, queries);
+    shuffle_keys(data, size);
+
+    Node* roots[2] = {NULL, NULL};
+    for (int i = 0; i < size; i++) {
+        roots[0] = bst_insert(roots[0], data[i]);
+        roots[1] = avl_insert(roots[1], data[i]);
+    }
+
+    printf("--- [묶음 탐색: 키 %d개, 탐색 %d회] ---\n", size, BENCH_QUERY_COUNT);
+    int status = 0;
+    for (int t = 0; t < 2; t++) {
+        const char* name = t == 0 ? "BST" : "AVL";
+        struct timespec start;
+
+        g_comparison_count = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < BENCH_QUERY_COUNT; i++) tree_search(roots[t], queries[i]);
+        double sequential = elapsed_seconds(&start);
+        long long sequential_comps = g_comparison_count;
+        printf("%s 하나씩      : %8.1f ns/탐색, %6.2f M탐색/s\n", name, sequential * 1e9 / BENCH_QUERY_COUNT,
+               BENCH_QUERY_COUNT / sequential / 1e6);
+
+        for (size_t k = 0; k < sizeof(groups) / sizeof(groups[0]); k++) {
+            g_comparison_count = 0;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            tree_search_batch(roots[t], queries, BENCH_QUERY_COUNT, groups[k], NULL);
+            double batched = elapsed_seconds(&start);
+            int same = g_comparison_count == sequential_comps;
+            if (!same) status = 1;
+            printf("%s 묶음 G=%-3d  : %8.1f ns/탐색, %6.2f M탐색/s (x%.2f, 비교 횟수 %s)\n", name, groups[k],
+                   batched * 1e9 / BENCH_QUERY_COUNT, BENCH_QUERY_COUNT / batched / 1e6, sequential / batched,
+                   same ? "일치" : "불일치");
+        }
+    }
+    printf("\n");
+
+    free_tree(roots[0]);
+    free_tree(roots[1]);
+    free(data);
+    free(queries);
+    return status;
+}
+
+// ========== 12. 메인 함수 ==========
+
+int main(int argc, char* argv[]) {
     // 난수 시드 초기화
     srand((unsigned int)time(NULL));
 
+    // --bench [키 수...]: 규모별 탐색 벤치마크 (기본 1천, 1백만, 1억)
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        static const int default_sizes[] = {1000, 1000000, 100000000};
+        PerfCounter counter;
+        int status = 0;
+        perf_counter_open_cache_misses(&counter);
+        if (argc == 2) {
+            for (int i = 0; i < 3; i++) status |= run_search_bench(default_sizes[i], &counter);
+        }
+        for (int i = 2; i < argc; i++) {
+            long long size = atoll(argv[i]);
+            if (size < 1 || size > 500000000) {
+                printf("잘못된 키 수: %s\n", argv[i]);
+                status = 1;
+                continue;
+            }
+            status |= run_search_bench((int)size, &counter);
+        }
+        perf_counter_close(&counter);
+        return status;
+    }
+
+    // --bench-batch [키 수]: BST/AVL 묶음 탐색과 하나씩 탐색의 처리량 비교 (기본 1천만)
+    if (argc >= 2 && strcmp(argv[1], "--bench-batch") == 0) {
+        long long size = argc >= 3 ? atoll(argv[2]) : 10000000;
+        if (size < 1 || size > 500000000) {
+            printf("잘못된 키 수: %s\n", argv[2]);
+            return 1;
+        }
+        return run_batch_bench((int)size);
+    }
+
     // 1000개의 초기 데이터(data)와 1000개의 탐색 키(keys)를 담을 배열
     int data[SIZE];
     int search_keys[SIZE];